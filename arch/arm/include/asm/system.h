@@ -84,6 +84,12 @@
 #define HCR_EL2_HCD_DIS		(1 << 29) /* Hypervisor Call disabled         */
 #define HCR_EL2_AMO_EL2		(1 <<  5) /* Route SErrors to EL2             */
 
+/*
+ * ID_AA64ISAR0_EL1 bits definitions
+ */
+#define ID_AA64ISAR0_EL1_SHA2	(0xF << 12) /* SHA-2 instructions             */
+#define ID_AA64ISAR0_EL1_SHA2_512 (0x2 << 12) /* SHA-512 instructions too     */
+
 /*
  * ID_AA64ISAR1_EL1 bits definitions
  */
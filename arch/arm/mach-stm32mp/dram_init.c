@@ -44,7 +44,7 @@ phys_size_t board_get_usable_ram_top(phys_size_t total_size)
 {
 	phys_size_t size;
 	phys_addr_t reg;
-	struct lmb lmb;
+	struct lmb lmb = {};
 
 	if (!total_size)
 		return gd->ram_top;
@@ -56,6 +56,7 @@ phys_size_t board_get_usable_ram_top(phys_size_t total_size)
 	/* add 8M for reserved memory for display, fdt, gd,... */
 	size = ALIGN(SZ_8M + CONFIG_SYS_MALLOC_LEN + total_size, MMU_SECTION_SIZE),
 	reg = lmb_alloc(&lmb, size, MMU_SECTION_SIZE);
+	lmb_uninit(&lmb);
 
 	if (!reg)
 		reg = gd->ram_top - size;
@@ -151,6 +151,48 @@ int sandbox_pwm_get_config(struct udevice *dev, uint channel, uint *period_nsp,
  */
 void sandbox_sf_set_block_protect(struct udevice *dev, int bp_mask);
 
+/**
+ * struct sandbox_mmc_counts - Commands seen by the sandbox MMC emulator
+ *
+ * @set_block_count: Number of CMD23 (SET_BLOCK_COUNT) commands
+ * @stop: Number of CMD12 (STOP_TRANSMISSION) commands
+ * @erase: Number of CMD38 (ERASE) commands
+ * @erase_busy: Number of those CMD38 commands which expected an R1b response
+ * @cache_on: Number of times the eMMC volatile cache was enabled
+ * @cache_off: Number of times the eMMC volatile cache was disabled
+ */
+struct sandbox_mmc_counts {
+	int set_block_count;
+	int stop;
+	int erase;
+	int erase_busy;
+	int cache_on;
+	int cache_off;
+};
+
+/**
+ * sandbox_mmc_set_emmc() - Switch the emulated card between SD and eMMC
+ *
+ * This replaces the card with an empty one and initialises it again. The
+ * eMMC is 8MB with 512KB erase groups, each taking 300ms to erase, and has a
+ * volatile cache. While it is in use the host behaves like sdhci: it
+ * transfers up to 64 blocks at a time and waits up to 1s for a busy card.
+ * The command counts are reset.
+ *
+ * @dev: MMC device to update (must not have a backing file)
+ * @emmc: true to emulate an eMMC, false for an SD card
+ * Returns: 0 if OK, -ve on error
+ */
+int sandbox_mmc_set_emmc(struct udevice *dev, bool emmc);
+
+/**
+ * sandbox_mmc_get_counts() - Get the commands seen by the MMC emulator
+ *
+ * @dev: MMC device to check
+ * Returns: pointer to the counts, which the caller may also reset
+ */
+struct sandbox_mmc_counts *sandbox_mmc_get_counts(struct udevice *dev);
+
 /**
  * sandbox_get_codec_params() - Read back codec parameters
  *
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * sha256_ni_glue.c - SHA-256 secure hash using the x86 SHA extensions
+ */
+
+#include <common.h>
+#include <cpuid.h>
+#include <u-boot/sha256.h>
+
+extern void sha256_ni_process(uint32_t state[8], const uint8_t *src,
+			      unsigned int blocks);
+
+/* The host CPU may lack the extensions, so check once before using them */
+static bool sha256_ni_supported(void)
+{
+	static int supported = -1;
+	unsigned int eax, ebx, ecx, edx;
+
+	if (supported < 0)
+		supported = __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+			    (ebx & bit_SHA);
+
+	return supported;
+}
+
+void sha256_process(sha256_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	if (!blocks)
+		return;
+
+	if (sha256_ni_supported())
+		sha256_ni_process(ctx->state, data, blocks);
+	else
+		sha256_process_generic(ctx, data, blocks);
+}
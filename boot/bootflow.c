@@ -11,7 +11,9 @@
 #include <bootflow.h>
 #include <bootmeth.h>
 #include <bootstd.h>
+#include <blk.h>
 #include <dm.h>
+#include <env.h>
 #include <malloc.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
@@ -22,6 +24,10 @@ enum {
 	BF_NO_MORE_DEVICES	= -ENODEV,
 };
 
+/* Environment variable holding the bootflow cache, and its maximum length */
+#define BOOTFLOW_CACHE_VAR	"bootflow_cache"
+#define BOOTFLOW_CACHE_LEN	256
+
 /**
  * bootflow_state - name for each state
  *
@@ -313,6 +319,14 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 	dev = iter->dev;
 	ret = bootdev_get_bootflow(dev, iter, bflow);
 
+	/* Skip the bootflow which was already returned from the cache */
+	if (CONFIG_IS_ENABLED(BOOTFLOW_CACHE) && !ret &&
+	    dev == iter->cache_dev && iter->part == iter->cache_part &&
+	    iter->method == iter->cache_method) {
+		bootflow_free(bflow);
+		ret = -EALREADY;
+	}
+
 	/* If we got a valid bootflow, return it */
 	if (!ret) {
 		log_debug("Bootdevice '%s' part %d method '%s': Found bootflow\n",
@@ -337,15 +351,150 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 	return 0;
 }
 
-int bootflow_scan_first(struct udevice *dev, const char *label,
-			struct bootflow_iter *iter, int flags,
-			struct bootflow *bflow)
+/**
+ * bootflow_cache_find() - Try the bootflow recorded by the last boot
+ *
+ * The record holds the media uclass, bootdev, partition, bootmeth, size and
+ * filename of the bootflow. It is still valid if the bootmeth can read a
+ * bootflow from that partition with the same filename and size. Reading it
+ * requires the same steps as the normal scan, so the check is cheap.
+ *
+ * On failure the iterator is left as it was, ready for the normal scan
+ *
+ * @iter: Iterator, with the bootmeth ordering set up
+ * @bflow: Returns the bootflow on success
+ * Return: 0 if OK, -ENOENT if there is no usable record, -ESTALE if the
+ *	bootflow has changed, other -ve if it could not be obtained
+ */
+static int bootflow_cache_find(struct bootflow_iter *iter,
+			       struct bootflow *bflow)
 {
-	int ret;
+	char *uc_name, *dev_name, *part_str, *meth_name, *size_str, *fname;
+	struct udevice *dev, *method;
+	char buf[BOOTFLOW_CACHE_LEN];
+	int ret, i, cur_method;
+	bool doing_global;
+	const char *val;
+	char *p;
+
+	val = env_get(BOOTFLOW_CACHE_VAR);
+	if (!val || strlcpy(buf, val, sizeof(buf)) >= sizeof(buf))
+		return -ENOENT;
+	p = buf;
+	uc_name = strsep(&p, " ");
+	dev_name = strsep(&p, " ");
+	part_str = strsep(&p, " ");
+	meth_name = strsep(&p, " ");
+	size_str = strsep(&p, " ");
+	fname = p;
+	if (!fname)
+		return log_msg_ret("rec", -ENOENT);
+
+	ret = uclass_find_device_by_name(UCLASS_BOOTDEV, dev_name, &dev);
+	if (ret && (iter->flags & BOOTFLOWIF_HUNT)) {
+		/* the bootdev may only appear once its media is hunted */
+		ret = bootdev_hunt(uc_name, false);
+		if (!ret)
+			ret = uclass_find_device_by_name(UCLASS_BOOTDEV,
+							 dev_name, &dev);
+	}
+	if (ret)
+		return log_msg_ret("dev", ret);
+	ret = device_probe(dev);
+	if (ret)
+		return log_msg_ret("probe", ret);
 
-	if (dev || label)
-		flags |= BOOTFLOWIF_SKIP_GLOBAL;
-	bootflow_iter_init(iter, flags);
+	for (i = 0; i < iter->num_methods; i++) {
+		if (!strcmp(meth_name, iter->method_order[i]->name))
+			break;
+	}
+	if (i == iter->num_methods)
+		return log_msg_ret("meth", -ENOENT);
+
+	if (IS_ENABLED(CONFIG_BOOTSTD_FULL) && (iter->flags & BOOTFLOWIF_SHOW))
+		printf("Trying cached bootflow in bootdev '%s':\n", dev->name);
+
+	cur_method = iter->cur_method;
+	method = iter->method;
+	doing_global = iter->doing_global;
+	iter->dev = dev;
+	iter->part = dectoul(part_str, NULL);
+	iter->cur_method = i;
+	iter->method = iter->method_order[i];
+	iter->doing_global = false;
+
+	ret = bootflow_check(iter, bflow);
+	if (!ret && (bflow->state != BOOTFLOWST_READY || !bflow->fname ||
+		     strcmp(bflow->fname, fname) ||
+		     bflow->size != hextoul(size_str, NULL)))
+		ret = -ESTALE;
+	if (ret) {
+		bootflow_free(bflow);
+		iter->dev = NULL;
+		iter->part = 0;
+		iter->max_part = 0;
+		iter->cur_method = cur_method;
+		iter->method = method;
+		iter->doing_global = doing_global;
+
+		return log_msg_ret("chk", ret);
+	}
+	log_debug("Using cached bootflow '%s'\n", bflow->name);
+	iter->cache_dev = dev;
+	iter->cache_part = iter->part;
+	iter->cache_method = iter->method;
+	iter->flags |= BOOTFLOWIF_CACHED;
+
+	return 0;
+}
+
+/**
+ * bootflow_cache_save() - Record a bootflow in the bootflow cache
+ *
+ * Only bootflows from block devices are recorded. The record is only written
+ * if it changes, and no other changes to the environment are saved with it.
+ *
+ * @bflow: Bootflow which is about to be booted
+ * Return: true if the record now describes @bflow, false if not
+ */
+static bool bootflow_cache_save(const struct bootflow *bflow)
+{
+	char buf[BOOTFLOW_CACHE_LEN];
+	struct blk_desc *desc;
+	const char *old;
+
+	if (!bflow->dev || !bflow->blk || !bflow->fname)
+		return false;
+	desc = dev_get_uclass_plat(bflow->blk);
+	if (snprintf(buf, sizeof(buf), "%s %s %d %s %x %s",
+		     blk_get_uclass_name(desc->uclass_id), bflow->dev->name,
+		     bflow->part, bflow->method->name, bflow->size,
+		     bflow->fname) >= sizeof(buf))
+		return false;
+	old = env_get(BOOTFLOW_CACHE_VAR);
+	if (old && !strcmp(old, buf))
+		return true;
+	if (env_save_var(BOOTFLOW_CACHE_VAR, buf))
+		return false;
+
+	return true;
+}
+
+/**
+ * bootflow_scan_start() - Start scanning bootdevs for bootflows
+ *
+ * @dev: Boot device to scan, NULL to work through all of them
+ * @label: Label to control the scan, NULL to work through all devices
+ * @iter: Iterator, as set up by bootflow_iter_init()
+ * @bflow: Place to put the bootflow if found
+ * Return: 0 if found, -ENODEV if no device, other -ve on other error
+ */
+static int bootflow_scan_start(struct udevice *dev, const char *label,
+			       struct bootflow_iter *iter,
+			       struct bootflow *bflow)
+{
+	int flags = iter->flags;
+	int ret;
 
 	/*
 	 * Set up the ordering of bootmeths. This sets iter->doing_global and
@@ -358,6 +507,12 @@ int bootflow_scan_first(struct udevice *dev, const char *label,
 	/* Find the first bootmeth (there must be at least one!) */
 	iter->method = iter->method_order[iter->cur_method];
 
+	/* Try whatever booted last time, unless that was done already */
+	if (CONFIG_IS_ENABLED(BOOTFLOW_CACHE) && !dev && !label &&
+	    !(flags & BOOTFLOWIF_ALL) && !iter->cache_dev &&
+	    !bootflow_cache_find(iter, bflow))
+		return 0;
+
 	if (!IS_ENABLED(CONFIG_BOOTMETH_GLOBAL) || !iter->doing_global) {
 		struct udevice *dev = NULL;
 		int method_flags;
@@ -385,10 +540,52 @@ int bootflow_scan_first(struct udevice *dev, const char *label,
 	return 0;
 }
 
+/**
+ * bootflow_scan_restart() - Start the normal scan after a cached bootflow
+ *
+ * The iterator is set up again from scratch, since booting the cached bootflow
+ * may have dropped a bootmeth. The cached bootflow is remembered so that it is
+ * not returned a second time.
+ *
+ * @iter: Iterator which returned the cached bootflow
+ * @bflow: Place to put the bootflow if found
+ * Return: 0 if found, -ENODEV if no device, other -ve on other error
+ */
+static int bootflow_scan_restart(struct bootflow_iter *iter,
+				 struct bootflow *bflow)
+{
+	struct udevice *cache_dev = iter->cache_dev;
+	struct udevice *cache_method = iter->cache_method;
+	int cache_part = iter->cache_part;
+
+	bootflow_iter_uninit(iter);
+	bootflow_iter_init(iter, iter->flags & ~BOOTFLOWIF_CACHED);
+	iter->cache_dev = cache_dev;
+	iter->cache_part = cache_part;
+	iter->cache_method = cache_method;
+
+	return bootflow_scan_start(NULL, NULL, iter, bflow);
+}
+
+int bootflow_scan_first(struct udevice *dev, const char *label,
+			struct bootflow_iter *iter, int flags,
+			struct bootflow *bflow)
+{
+	if (dev || label)
+		flags |= BOOTFLOWIF_SKIP_GLOBAL;
+	bootflow_iter_init(iter, flags);
+
+	return bootflow_scan_start(dev, label, iter, bflow);
+}
+
 int bootflow_scan_next(struct bootflow_iter *iter, struct bootflow *bflow)
 {
 	int ret;
 
+	if (CONFIG_IS_ENABLED(BOOTFLOW_CACHE) &&
+	    (iter->flags & BOOTFLOWIF_CACHED))
+		return bootflow_scan_restart(iter, bflow);
+
 	do {
 		ret = iter_incr(iter);
 		log_debug("iter_incr: ret=%d\n", ret);
@@ -463,6 +660,7 @@ int bootflow_boot(struct bootflow *bflow)
 
 int bootflow_run_boot(struct bootflow_iter *iter, struct bootflow *bflow)
 {
+	bool cached = false;
 	int ret;
 
 	printf("** Booting bootflow '%s' with %s\n", bflow->name,
@@ -470,7 +668,20 @@ int bootflow_run_boot(struct bootflow_iter *iter, struct bootflow *bflow)
 	if (IS_ENABLED(CONFIG_OF_HAS_PRIOR_STAGE) &&
 	    (bflow->flags & BOOTFLOWF_USE_PRIOR_FDT))
 		printf("Using prior-stage device tree\n");
+
+	/* A successful boot does not return, so record the bootflow first */
+	if (CONFIG_IS_ENABLED(BOOTFLOW_CACHE) &&
+	    bflow->state == BOOTFLOWST_READY)
+		cached = bootflow_cache_save(bflow);
 	ret = bootflow_boot(bflow);
+
+	/*
+	 * Don't try this bootflow first again in this session, since it failed.
+	 * The stored record is left alone, to avoid another write: it is
+	 * replaced when a different bootflow boots.
+	 */
+	if (cached)
+		env_set(BOOTFLOW_CACHE_VAR, NULL);
 	if (!IS_ENABLED(CONFIG_BOOTSTD_FULL)) {
 		printf("Boot failed (err=%d)\n", ret);
 		return ret;
@@ -63,14 +63,22 @@ static void boot_start_lmb(struct bootm_headers *images)
 	lmb_init_and_reserve_range(&images->lmb, (phys_addr_t)mem_start,
 				   mem_size, NULL);
 }
+
+/* Free any regions allocated by a previous bootm */
+static void boot_stop_lmb(struct bootm_headers *images)
+{
+	lmb_uninit(&images->lmb);
+}
 #else
 #define lmb_reserve(lmb, base, size)
 static inline void boot_start_lmb(struct bootm_headers *images) { }
+static inline void boot_stop_lmb(struct bootm_headers *images) { }
 #endif
 
 static int bootm_start(struct cmd_tbl *cmdtp, int flag, int argc,
 		       char *const argv[])
 {
+	boot_stop_lmb(&images);
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
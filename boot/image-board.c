@@ -575,6 +575,8 @@ int boot_get_ramdisk(int argc, char *const argv[], struct bootm_headers *images,
  *
  * boot_ramdisk_high() takes a relocation hint from "initrd_high" environment
  * variable and if requested ramdisk data is moved to a specified location.
+ * With CONFIG_BOOTM_IN_PLACE, ramdisk data which is already in a suitable,
+ * free location is used where it is.
  *
  * Initrd_start and initrd_end are set to final (after relocation) ramdisk
  * start/end addresses if ramdisk image start and len were provided,
@@ -612,6 +614,20 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 			*initrd_start = rd_data;
 			*initrd_end = rd_data + rd_len;
 			lmb_reserve(lmb, rd_data, rd_len);
+		} else if (IS_ENABLED(CONFIG_BOOTM_IN_PLACE) &&
+			   lmb_alloc_in_place(lmb, rd_data, rd_len, 0x1000,
+					      initrd_high)) {
+			/* already loaded below initrd_high, so no need to copy */
+			*initrd_start = rd_data;
+			*initrd_end = rd_data + rd_len;
+			printf("   Using Ramdisk in place at %08lx, end %08lx\n",
+			       *initrd_start, *initrd_end);
+
+			/* As below, the image may not be cache coherent for AMP */
+			if (IS_ENABLED(CONFIG_MP)) {
+				flush_cache((unsigned long)*initrd_start,
+					    ALIGN(rd_len, ARCH_DMA_MINALIGN));
+			}
 		} else {
 			if (initrd_high)
 				*initrd_start = (ulong)lmb_alloc_base(lmb,
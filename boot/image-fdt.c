@@ -141,6 +141,26 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 	}
 }
 
+/**
+ * boot_fdt_in_place() - Reserve the FDT where it is, if that is suitable
+ *
+ * @lmb: pointer to lmb handle, will be used for memory mgmt
+ * @fdt_blob: FDT to reserve
+ * @of_len: size of the FDT including padding
+ * @max_addr: address which the FDT must end at or below, 0 for no limit
+ * Return: @fdt_blob if it was reserved in place, else NULL
+ */
+static void *boot_fdt_in_place(struct lmb *lmb, void *fdt_blob, ulong of_len,
+			       ulong max_addr)
+{
+	if (!IS_ENABLED(CONFIG_BOOTM_IN_PLACE) ||
+	    !lmb_alloc_in_place(lmb, map_to_sysmem(fdt_blob), of_len, 0x1000,
+				max_addr))
+		return NULL;
+
+	return fdt_blob;
+}
+
 /**
  * boot_relocate_fdt - relocate flat device tree
  * @lmb: pointer to lmb handle, will be used for memory mgmt
@@ -150,7 +170,8 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
  * boot_relocate_fdt() allocates a region of memory within the bootmap and
  * relocates the of_flat_tree into that region, even if the fdt is already in
  * the bootmap.  It also expands the size of the fdt by CONFIG_SYS_FDT_PAD
- * bytes.
+ * bytes. With CONFIG_BOOTM_IN_PLACE, an fdt which is already in a suitable
+ * location, with free space for the padding after it, is expanded in place.
  *
  * of_flat_tree and of_size are set to final (after relocation) values
  *
@@ -195,23 +216,32 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 			lmb_reserve(lmb, map_to_sysmem(of_start), of_len);
 			disable_relocation = 1;
 		} else if (desired_addr) {
-			addr = lmb_alloc_base(lmb, of_len, 0x1000,
-					      desired_addr);
-			of_start = map_sysmem(addr, of_len);
+			of_start = boot_fdt_in_place(lmb, fdt_blob, of_len,
+						     desired_addr);
+			if (!of_start) {
+				addr = lmb_alloc_base(lmb, of_len, 0x1000,
+						      desired_addr);
+				of_start = map_sysmem(addr, of_len);
+			}
 			if (of_start == NULL) {
 				puts("Failed using fdt_high value for Device Tree");
 				goto error;
 			}
 		} else {
-			addr = lmb_alloc(lmb, of_len, 0x1000);
-			of_start = map_sysmem(addr, of_len);
+			of_start = boot_fdt_in_place(lmb, fdt_blob, of_len, 0);
+			if (!of_start) {
+				addr = lmb_alloc(lmb, of_len, 0x1000);
+				of_start = map_sysmem(addr, of_len);
+			}
 		}
 	} else {
 		mapsize = env_get_bootm_mapsize();
 		low = env_get_bootm_low();
-		of_start = NULL;
+		of_start = boot_fdt_in_place(lmb, fdt_blob, of_len,
+					     low + mapsize);
 
-		for (bank = 0; bank < CONFIG_NR_DRAM_BANKS; bank++) {
+		for (bank = 0; !of_start && bank < CONFIG_NR_DRAM_BANKS;
+		     bank++) {
 			start = gd->bd->bi_dram[bank].start;
 			size = gd->bd->bi_dram[bank].size;
 
@@ -258,8 +288,12 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 		debug("## device tree at %p ... %p (len=%ld [0x%lX])\n",
 		      fdt_blob, fdt_blob + *of_size - 1, of_len, of_len);
 
-		printf("   Loading Device Tree to %p, end %p ... ",
-		       of_start, of_start + of_len - 1);
+		if (of_start == fdt_blob)
+			printf("   Using Device Tree in place at %p, end %p ... ",
+			       of_start, of_start + of_len - 1);
+		else
+			printf("   Loading Device Tree to %p, end %p ... ",
+			       of_start, of_start + of_len - 1);
 
 		err = fdt_open_into(fdt_blob, of_start, of_len);
 		if (err != 0) {
@@ -2343,11 +2343,11 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 	ulong load, len;
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
 	ulong image_start, image_end;
-	ulong ovload, ovlen, ovcopylen;
+	ulong ovload, ovlen, ovcopylen, ovtotal = 0;
 	const char *uconfig;
 	const char *uname;
-	void *base, *ov, *ovcopy = NULL;
-	int i, err, noffset, ov_noffset;
+	void *base, *ov, *ovcopy, **ovs = NULL, **new_ovs;
+	int i, err, noffset, ov_noffset, ovcount = 0;
 #endif
 
 	fit_uname = fit_unamep ? *fit_unamep : NULL;
@@ -2399,8 +2399,6 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 		goto out;
 	}
 
-	base = map_sysmem(load, len);
-
 	/* apply extra configs in FIT first, followed by args */
 	for (i = 1; ; i++) {
 		if (i < count) {
@@ -2445,6 +2443,13 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 				uname, ovload, ovlen);
 		ov = map_sysmem(ovload, ovlen);
 
+		new_ovs = realloc(ovs, (ovcount + 1) * sizeof(*ovs));
+		if (!new_ovs) {
+			fdt_noffset = -ENOMEM;
+			goto out;
+		}
+		ovs = new_ovs;
+
 		ovcopylen = ALIGN(fdt_totalsize(ov), SZ_4K);
 		ovcopy = malloc(ovcopylen);
 		if (!ovcopy) {
@@ -2452,31 +2457,45 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 			fdt_noffset = -ENOMEM;
 			goto out;
 		}
+		ovs[ovcount++] = ovcopy;
 
+		/*
+		 * Take a copy now, since loading the next DTO may overwrite
+		 * this one, and application modifies the DTO
+		 */
 		err = fdt_open_into(ov, ovcopy, ovcopylen);
 		if (err < 0) {
 			printf("failed on fdt_open_into for DTO\n");
 			fdt_noffset = err;
 			goto out;
 		}
+		ovtotal += ovlen;
+	}
 
-		base = map_sysmem(load, len + ovlen);
-		err = fdt_open_into(base, base, len + ovlen);
-		if (err < 0) {
-			printf("failed on fdt_open_into\n");
-			fdt_noffset = err;
-			goto out;
-		}
+	if (!ovcount)
+		goto out;
+
+	/* Make room for all the DTOs at once, then pack once at the end */
+	base = map_sysmem(load, len + ovtotal);
+	err = fdt_open_into(base, base, len + ovtotal);
+	if (err < 0) {
+		printf("failed on fdt_open_into\n");
+		fdt_noffset = err;
+		goto out;
+	}
 
+	for (i = 0; i < ovcount; i++) {
 		/* the verbose method prints out messages on error */
-		err = fdt_overlay_apply_verbose(base, ovcopy);
+		err = fdt_overlay_apply_verbose(base, ovs[i]);
 		if (err < 0) {
 			fdt_noffset = err;
 			goto out;
 		}
-		fdt_pack(base);
-		len = fdt_totalsize(base);
+		free(ovs[i]);
+		ovs[i] = NULL;
 	}
+	fdt_pack(base);
+	len = fdt_totalsize(base);
 #else
 	printf("config with overlays but CONFIG_OF_LIBFDT_OVERLAY not set\n");
 	fdt_noffset = -EBADF;
@@ -2493,7 +2512,9 @@ out:
 		*fit_uname_configp = fit_uname_config;
 
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
-	free(ovcopy);
+	for (i = 0; i < ovcount; i++)
+		free(ovs[i]);
+	free(ovs);
 #endif
 	free(fit_uname_config_copy);
 	return fdt_noffset;
@@ -394,6 +394,7 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 	char *fdtoverlay_addr_env;
 	ulong fdtoverlay_addr;
 	ulong fdt_addr;
+	uint used;
 	int err;
 
 	/* Get the main fdt and map it */
@@ -444,9 +445,6 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 			goto skip_overlay;
 		}
 
-		/* Resize main fdt */
-		fdt_shrink_to_minimum(working_fdt, 8192);
-
 		blob = map_sysmem(fdtoverlay_addr, 0);
 		err = fdt_check_header(blob);
 		if (err) {
@@ -455,6 +453,16 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 			goto skip_overlay;
 		}
 
+		/*
+		 * Resize main fdt only if the overlay may not fit in the space
+		 * left over by the previous one
+		 */
+		used = fdt_off_dt_strings(working_fdt) +
+			fdt_size_dt_strings(working_fdt);
+		if (fdt_totalsize(working_fdt) - used < fdt_totalsize(blob))
+			fdt_shrink_to_minimum(working_fdt,
+					      fdt_totalsize(blob) + 8192);
+
 		err = fdt_overlay_apply_verbose(working_fdt, blob);
 		if (err) {
 			printf("Failed to apply overlay %s, skipping\n",
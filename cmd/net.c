@@ -138,7 +138,8 @@ U_BOOT_CMD(dhcp6,	3,	1,	do_dhcp6,
 static int do_dhcp(struct cmd_tbl *cmdtp, int flag, int argc,
 		   char *const argv[])
 {
-	return netboot_common(DHCP, cmdtp, argc, argv);
+	return netboot_common(IS_ENABLED(CONFIG_NET_DHCP_RACE) ? DHCP_RACE :
+			      DHCP, cmdtp, argc, argv);
 }
 
 U_BOOT_CMD(
@@ -332,6 +332,9 @@ struct in_str {
 	int promptmode;
 #ifndef __U_BOOT__
 	FILE *file;
+#endif
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	struct parse_cache_entry *cache;	/* keeps the lists as they run */
 #endif
 	int (*get) (struct in_str *);
 	int (*peek) (struct in_str *);
@@ -1160,6 +1163,9 @@ static void setup_file_in_str(struct in_str *i)
 	i->file = f;
 #endif
 	i->p = NULL;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	i->cache = NULL;
+#endif
 }
 
 static void setup_string_in_str(struct in_str *i, const char *s)
@@ -1169,6 +1175,9 @@ static void setup_string_in_str(struct in_str *i, const char *s)
 	i->__promptme=1;
 	i->promptmode=1;
 	i->p = s;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	i->cache = NULL;
+#endif
 }
 
 #ifndef __U_BOOT__
@@ -1538,6 +1547,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1550,6 +1560,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1616,6 +1627,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* count locally, the pipe may be run again */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1624,11 +1637,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1756,6 +1769,24 @@ static int run_pipe_real(struct pipe *pi)
 	return -1;
 }
 
+#ifdef __U_BOOT__
+/*
+ * Put back the variable name of a "for" loop which is left early, so that
+ * the pipe can be freed or run again
+ */
+static void end_for_list(struct pipe *pi, char **list, char **save_list,
+			 char *save_name)
+{
+	if (!list)
+		return;
+	free(pi->progs->argv[0]);
+	while (*list)
+		free(*list++);
+	free(save_list);
+	pi->progs->argv[0] = save_name;
+}
+#endif
+
 static int run_list_real(struct pipe *pi)
 {
 	char *save_name = NULL;
@@ -1800,6 +1831,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
+					end_for_list(rpipe, list, save_list,
+						     save_name);
 					return 1;
 				}
 #endif
@@ -1899,6 +1932,7 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
+			end_for_list(rpipe, list, save_list, save_name);
 			return -2;	/* exit */
 		}
 		last_return_code = rcode;
@@ -3174,6 +3208,138 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/* Number of parsed strings kept for running again */
+#define PARSE_CACHE_SIZE	16
+
+/**
+ * struct parse_cache_entry - A string which is parsed once and run many times
+ *
+ * Commands run through 'run', bootcmd and scripts are usually the same strings
+ * over and over. Parsing turns the text into lists of pipes, which only refer
+ * to variables by name and so can be run again unchanged.
+ *
+ * @text: String which was parsed, NULL if the entry is free
+ * @flag: Parser flags used for @text
+ * @lists: Command lists, one for each time the parser stopped
+ * @count: Number of entries in @lists
+ * @busy: Number of runs of this entry in progress
+ * @bad: true if the lists cannot be kept, e.g. after a syntax error
+ * @last_used: Value of parse_cache_seq when last used, for eviction
+ */
+struct parse_cache_entry {
+	char *text;
+	int flag;
+	struct pipe **lists;
+	int count;
+	int busy;
+	bool bad;
+	ulong last_used;
+};
+
+static struct parse_cache_entry parse_cache[PARSE_CACHE_SIZE];
+static ulong parse_cache_seq;
+
+static void parse_cache_free(struct parse_cache_entry *ent)
+{
+	int i;
+
+	for (i = 0; i < ent->count; i++)
+		free_pipe_list(ent->lists[i], 0);
+	free(ent->lists);
+	free(ent->text);
+	memset(ent, '\0', sizeof(*ent));
+}
+
+static struct parse_cache_entry *parse_cache_find(const char *s, int flag)
+{
+	struct parse_cache_entry *ent;
+
+	for (ent = parse_cache; ent < parse_cache + PARSE_CACHE_SIZE; ent++) {
+		if (ent->text && ent->flag == flag && !strcmp(ent->text, s))
+			return ent;
+	}
+
+	return NULL;
+}
+
+/* Run a list as it is parsed, keeping it for next time */
+static int parse_cache_keep(struct parse_cache_entry *ent, struct pipe *pi)
+{
+	struct pipe **lists;
+	int code;
+
+	code = run_list_real(pi);
+	lists = realloc(ent->lists, (ent->count + 1) * sizeof(*lists));
+	if (!lists) {
+		free_pipe_list(pi, 0);
+		ent->bad = true;
+		return code;
+	}
+	ent->lists = lists;
+	ent->lists[ent->count++] = pi;
+	if (code == -2)		/* exit, the rest is not parsed */
+		ent->bad = true;
+
+	return code;
+}
+
+/* Put a fully parsed string in the cache, in place of the oldest idle one */
+static void parse_cache_store(struct parse_cache_entry *new)
+{
+	struct parse_cache_entry *ent, *slot = NULL;
+
+	if (new->bad || parse_cache_find(new->text, new->flag)) {
+		parse_cache_free(new);
+		return;
+	}
+	for (ent = parse_cache; ent < parse_cache + PARSE_CACHE_SIZE; ent++) {
+		if (ent->busy)
+			continue;
+		if (!slot || !ent->text ||
+		    (slot->text && ent->last_used < slot->last_used))
+			slot = ent;
+		if (!slot->text)
+			break;
+	}
+	if (!slot) {
+		parse_cache_free(new);
+		return;
+	}
+	if (slot->text)
+		parse_cache_free(slot);
+	*slot = *new;
+	slot->last_used = ++parse_cache_seq;
+}
+
+/* Run a string parsed earlier; returns false if it is not in the cache */
+static bool parse_cache_run(const char *s, int flag, int *rcodep)
+{
+	struct parse_cache_entry *ent;
+	int code = 1;
+	int i;
+
+	ent = parse_cache_find(s, flag);
+	/* A string which runs itself gets parsed again for the inner run */
+	if (!ent || ent->busy)
+		return false;
+
+	ent->busy++;
+	ent->last_used = ++parse_cache_seq;
+	for (i = 0; i < ent->count; i++) {
+		code = run_list_real(ent->lists[i]);
+		if (code == -2)
+			break;
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	ent->busy--;
+	*rcodep = code == -2 ? -2 : code != 0;
+
+	return true;
+}
+#endif
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
 static int parse_stream_outer(struct in_str *inp, int flag)
@@ -3208,6 +3374,12 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (inp->cache)
+				code = parse_cache_keep(inp->cache,
+							ctx.list_head);
+			else
+#endif
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
 				b_free(&temp);
@@ -3243,6 +3415,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			temp.quote = 0;
 			inp->p = NULL;
 			free_pipe_list(ctx.list_head,0);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (inp->cache)
+				inp->cache->bad = true;
+#endif
 		}
 		b_free(&temp);
 	/* loop on syntax errors, return on EOF */
@@ -3265,25 +3441,49 @@ int parse_string_outer(const char *s, int flag)
 	int rcode;
 #ifdef __U_BOOT__
 	char *p = NULL;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	struct parse_cache_entry ent = { .flag = flag };
+#endif
 	if (!s)
 		return 1;
 	if (!*s)
 		return 0;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	/* Reparsed strings have variables substituted, so rarely repeat */
+	if (!(flag & FLAG_REPARSING)) {
+		if (parse_cache_run(s, flag, &rcode))
+			return rcode == -2 ? last_return_code : rcode;
+		ent.text = strdup(s);
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		if (ent.text)
+			input.cache = &ent;
+#endif
 		rcode = parse_stream_outer(&input, flag);
 		free(p);
-		return rcode == -2 ? last_return_code : rcode;
 	} else {
+		setup_string_in_str(&input, s);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		if (ent.text)
+			input.cache = &ent;
+#endif
+		rcode = parse_stream_outer(&input, flag);
+	}
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	if (ent.text)
+		parse_cache_store(&ent);
 #endif
+	return rcode == -2 ? last_return_code : rcode;
+#else
 	setup_string_in_str(&input, s);
 	rcode = parse_stream_outer(&input, flag);
 	return rcode == -2 ? last_return_code : rcode;
-#ifdef __U_BOOT__
-	}
 #endif
 }
 
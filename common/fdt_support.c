@@ -10,6 +10,7 @@
 #include <abuf.h>
 #include <env.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <net.h>
 #include <stdio_dev.h>
@@ -406,6 +407,147 @@ void do_fixup_by_compat_u32(void *fdt, const char *compat,
 	do_fixup_by_compat(fdt, compat, prop, &tmp, 4, create);
 }
 
+/**
+ * struct fdt_fixup_edit - A property update recorded in a fixup session
+ *
+ * @node: Offset of node to update
+ * @create: true to create the property if it does not exist
+ * @len: Length of @val in bytes
+ * @name: Name of property; the allocation also holds @val
+ * @val: Value of property
+ */
+struct fdt_fixup_edit {
+	int node;
+	bool create;
+	int len;
+	char *name;
+	void *val;
+};
+
+void fdt_fixup_begin(struct fdt_fixup_session *sess, void *fdt)
+{
+	memset(sess, '\0', sizeof(*sess));
+	sess->fdt = fdt;
+}
+
+void fdt_fixup_abort(struct fdt_fixup_session *sess)
+{
+	int i;
+
+	for (i = 0; i < sess->count; i++)
+		free(sess->edits[i].name);
+	free(sess->edits);
+	sess->edits = NULL;
+	sess->count = 0;
+	sess->alloced = 0;
+}
+
+int fdt_fixup_setprop(struct fdt_fixup_session *sess, int nodeoffset,
+		      const char *name, const void *val, int len, bool create)
+{
+	struct fdt_fixup_edit *edit;
+	int namelen, lo, hi, mid;
+	char *buf;
+
+	if (!fdt_get_name(sess->fdt, nodeoffset, NULL))
+		return -FDT_ERR_BADOFFSET;
+	if (!create && !fdt_get_property(sess->fdt, nodeoffset, name, NULL))
+		return 0;
+
+	namelen = strlen(name) + 1;
+	buf = malloc(namelen + len);
+	if (!buf)
+		return -FDT_ERR_NOSPACE;
+	memcpy(buf, name, namelen);
+	memcpy(buf + namelen, val, len);
+
+	/* Find the end of the updates for this node */
+	lo = 0;
+	hi = sess->count;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (sess->edits[mid].node <= nodeoffset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* Replace an earlier update of the same property */
+	for (mid = lo - 1; mid >= 0 && sess->edits[mid].node == nodeoffset;
+	     mid--) {
+		edit = &sess->edits[mid];
+		if (!strcmp(edit->name, name)) {
+			free(edit->name);
+			edit->create |= create;
+			goto set;
+		}
+	}
+
+	if (sess->count == sess->alloced) {
+		int alloced = sess->alloced ? sess->alloced * 2 : 16;
+
+		edit = realloc(sess->edits, alloced * sizeof(*edit));
+		if (!edit) {
+			free(buf);
+			return -FDT_ERR_NOSPACE;
+		}
+		sess->edits = edit;
+		sess->alloced = alloced;
+	}
+	edit = &sess->edits[lo];
+	memmove(edit + 1, edit, (sess->count - lo) * sizeof(*edit));
+	sess->count++;
+	edit->node = nodeoffset;
+	edit->create = create;
+set:
+	edit->name = buf;
+	edit->val = buf + namelen;
+	edit->len = len;
+
+	return 0;
+}
+
+/*
+ * Apply the updates with fdt_setprop(), working back from the last node, since
+ * updating a node only moves the nodes after it. A failed update is reported
+ * and the others are still applied.
+ */
+static int fdt_fixup_apply(struct fdt_fixup_session *sess)
+{
+	struct fdt_fixup_edit *edit;
+	char path[256];
+	int i, ret, err = 0;
+
+	for (i = sess->count - 1; i >= 0; i--) {
+		edit = &sess->edits[i];
+		if (!edit->create &&
+		    !fdt_get_property(sess->fdt, edit->node, edit->name, NULL))
+			continue;
+		ret = fdt_setprop(sess->fdt, edit->node, edit->name, edit->val,
+				  edit->len);
+		if (ret) {
+			if (fdt_get_path(sess->fdt, edit->node, path,
+					 sizeof(path)))
+				strcpy(path, "?");
+			printf("Unable to update property %s:%s, err=%s\n",
+			       path, edit->name, fdt_strerror(ret));
+			err = ret;
+		}
+	}
+
+	return err;
+}
+
+int fdt_fixup_commit(struct fdt_fixup_session *sess)
+{
+	int ret;
+
+	ret = fdt_fixup_apply(sess);
+	fdt_fixup_abort(sess);
+
+	return ret;
+}
+
 #ifdef CONFIG_ARCH_FIXUP_FDT_MEMORY
 /*
  * fdt_pack_reg - pack address and size array into the "reg"-suitable stream
@@ -552,37 +694,46 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 	return fdt_fixup_memory_banks(blob, &start, &size, 1);
 }
 
+/* Record an update of a MAC-address property, reporting any failure */
+static void fdt_fixup_mac_prop(struct fdt_fixup_session *sess,
+			       const char *path, int nodeoff, const char *prop,
+			       const unsigned char *mac_addr, bool create)
+{
+	int ret = nodeoff;
+
+	if (nodeoff >= 0)
+		ret = fdt_fixup_setprop(sess, nodeoff, prop, mac_addr, ARP_HLEN,
+					create);
+	if (ret < 0)
+		printf("Unable to update property %s:%s, err=%s\n", path, prop,
+		       fdt_strerror(ret));
+}
+
 void fdt_fixup_ethernet(void *fdt)
 {
+	struct fdt_fixup_session sess;
 	int i = 0, j, prop;
 	char *tmp, *end;
 	char mac[16];
 	const char *path;
 	unsigned char mac_addr[ARP_HLEN];
-	int offset;
+	int aliases, nodeoff;
 #ifdef FDT_SEQ_MACADDR_FROM_ENV
-	int nodeoff;
 	const struct fdt_property *fdt_prop;
 #endif
 
-	if (fdt_path_offset(fdt, "/aliases") < 0)
+	aliases = fdt_path_offset(fdt, "/aliases");
+	if (aliases < 0)
 		return;
 
+	/* The FDT is only changed at the end, so offsets stay valid */
+	fdt_fixup_begin(&sess, fdt);
+
 	/* Cycle through all aliases */
-	for (prop = 0; ; prop++) {
+	fdt_for_each_property_offset(prop, fdt, aliases) {
 		const char *name;
 
-		/* FDT might have been edited, recompute the offset */
-		offset = fdt_first_property_offset(fdt,
-			fdt_path_offset(fdt, "/aliases"));
-		/* Select property number 'prop' */
-		for (j = 0; j < prop; j++)
-			offset = fdt_next_property_offset(fdt, offset);
-
-		if (offset < 0)
-			break;
-
-		path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
+		path = fdt_getprop_by_offset(fdt, prop, &name, NULL);
 		if (!strncmp(name, "ethernet", 8)) {
 			/* Treat plain "ethernet" same as "ethernet0". */
 			if (!strcmp(name, "ethernet")
@@ -603,8 +754,8 @@ void fdt_fixup_ethernet(void *fdt)
 			} else {
 				continue;
 			}
-#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			nodeoff = fdt_path_offset(fdt, path);
+#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			fdt_prop = fdt_get_property(fdt, nodeoff, "status",
 						    NULL);
 			if (fdt_prop && !strcmp(fdt_prop->data, "disabled"))
@@ -622,12 +773,15 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			fdt_fixup_mac_prop(&sess, path, nodeoff, "mac-address",
+					   mac_addr, false);
+			fdt_fixup_mac_prop(&sess, path, nodeoff,
+					   "local-mac-address", mac_addr, true);
 		}
 	}
+
+	/* Failures are reported for each property */
+	fdt_fixup_commit(&sess);
 }
 
 int fdt_record_loadable(void *blob, u32 index, const char *name,
@@ -18,6 +18,28 @@
 #include <asm/global_data.h>
 #include <dm/ofnode.h>
 
+/**
+ * spl_spi_read() - read from the boot flash
+ *
+ * With CONFIG_SPL_SPI_LOAD_MMAP, data inside the memory-mapped window is
+ * read from the window, see spi_flash_read_mmap().
+ *
+ * @flash:	SPI flash
+ * @map:	memory-mapped window
+ * @offs:	offset in the flash
+ * @len:	number of bytes to read
+ * @buf:	destination buffer
+ * Return:	0 if OK, -ve on error
+ */
+static int spl_spi_read(struct spi_flash *flash, struct spi_flash_mmap *map,
+			u32 offs, size_t len, void *buf)
+{
+	if (CONFIG_IS_ENABLED(SPI_LOAD_MMAP))
+		return spi_flash_read_mmap(flash->dev, map, offs, len, buf);
+
+	return spi_flash_read(flash, offs, len, buf);
+}
+
 #if CONFIG_IS_ENABLED(OS_BOOT)
 /*
  * Load the kernel, check for a valid header we can parse, and if found load
@@ -26,13 +48,14 @@
 static int spi_load_image_os(struct spl_image_info *spl_image,
 			     struct spl_boot_device *bootdev,
 			     struct spi_flash *flash,
+			     struct spi_flash_mmap *map,
 			     struct legacy_img_hdr *header)
 {
 	int err;
 
 	/* Read for a header, parse or error out. */
-	spi_flash_read(flash, CFG_SYS_SPI_KERNEL_OFFS, sizeof(*header),
-		       (void *)header);
+	spl_spi_read(flash, map, CFG_SYS_SPI_KERNEL_OFFS, sizeof(*header),
+		     (void *)header);
 
 	if (image_get_magic(header) != IH_MAGIC)
 		return -1;
@@ -41,13 +64,13 @@ static int spi_load_image_os(struct spl_image_info *spl_image,
 	if (err)
 		return err;
 
-	spi_flash_read(flash, CFG_SYS_SPI_KERNEL_OFFS,
-		       spl_image->size, (void *)spl_image->load_addr);
+	spl_spi_read(flash, map, CFG_SYS_SPI_KERNEL_OFFS,
+		     spl_image->size, (void *)spl_image->load_addr);
 
 	/* Read device tree. */
-	spi_flash_read(flash, CFG_SYS_SPI_ARGS_OFFS,
-		       CFG_SYS_SPI_ARGS_SIZE,
-		       (void *)CONFIG_SYS_SPL_ARGS_ADDR);
+	spl_spi_read(flash, map, CFG_SYS_SPI_ARGS_OFFS,
+		     CFG_SYS_SPI_ARGS_SIZE,
+		     (void *)CONFIG_SYS_SPL_ARGS_ADDR);
 
 	return 0;
 }
@@ -59,7 +82,7 @@ static ulong spl_spi_fit_read(struct spl_load_info *load, ulong sector,
 	struct spi_flash *flash = load->dev;
 	ulong ret;
 
-	ret = spi_flash_read(flash, sector, count, buf);
+	ret = spl_spi_read(flash, load->priv, sector, count, buf);
 	if (!ret)
 		return count;
 	else
@@ -92,6 +115,7 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 	int err = 0;
 	unsigned int payload_offs;
 	struct spi_flash *flash;
+	struct spi_flash_mmap map = {};
 	struct legacy_img_hdr *header;
 	unsigned int sf_bus = spl_spi_boot_bus();
 	unsigned int sf_cs = spl_spi_boot_cs();
@@ -109,6 +133,14 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 		return -ENODEV;
 	}
 
+#if CONFIG_IS_ENABLED(SPI_LOAD_MMAP)
+	if (dm_spi_get_mmap(flash->dev, &map.base, &map.size, &map.offset))
+		map.size = 0;
+	else
+		debug("%s: flash mapped at %lx, size %x, offset %x\n",
+		      __func__, map.base, map.size, map.offset);
+#endif
+
 	payload_offs = spl_spi_get_uboot_offs(flash);
 
 	header = spl_get_load_buffer(-sizeof(*header), sizeof(*header));
@@ -119,12 +151,13 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 	}
 
 #if CONFIG_IS_ENABLED(OS_BOOT)
-	if (spl_start_uboot() || spi_load_image_os(spl_image, bootdev, flash, header))
+	if (spl_start_uboot() ||
+	    spi_load_image_os(spl_image, bootdev, flash, &map, header))
 #endif
 	{
 		/* Load u-boot, mkimage header is 64 bytes. */
-		err = spi_flash_read(flash, payload_offs, sizeof(*header),
-				     (void *)header);
+		err = spl_spi_read(flash, &map, payload_offs, sizeof(*header),
+				   (void *)header);
 		if (err) {
 			debug("%s: Failed to read from SPI flash (err=%d)\n",
 			      __func__, err);
@@ -133,9 +166,9 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 
 		if (IS_ENABLED(CONFIG_SPL_LOAD_FIT_FULL) &&
 		    image_get_magic(header) == FDT_MAGIC) {
-			err = spi_flash_read(flash, payload_offs,
-					     roundup(fdt_totalsize(header), 4),
-					     (void *)CONFIG_SYS_LOAD_ADDR);
+			err = spl_spi_read(flash, &map, payload_offs,
+					   roundup(fdt_totalsize(header), 4),
+					   (void *)CONFIG_SYS_LOAD_ADDR);
 			if (err)
 				return err;
 			err = spl_parse_image_header(spl_image, bootdev,
@@ -146,7 +179,7 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 
 			debug("Found FIT\n");
 			load.dev = flash;
-			load.priv = NULL;
+			load.priv = &map;
 			load.filename = NULL;
 			load.bl_len = 1;
 			load.read = spl_spi_fit_read;
@@ -157,7 +190,7 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 			struct spl_load_info load;
 
 			load.dev = flash;
-			load.priv = NULL;
+			load.priv = &map;
 			load.filename = NULL;
 			load.bl_len = 1;
 			load.read = spl_spi_fit_read;
@@ -168,9 +201,10 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 			err = spl_parse_image_header(spl_image, bootdev, header);
 			if (err)
 				return err;
-			err = spi_flash_read(flash, payload_offs + spl_image->offset,
-					     spl_image->size,
-					     (void *)spl_image->load_addr);
+			err = spl_spi_read(flash, &map,
+					   payload_offs + spl_image->offset,
+					   spl_image->size,
+					   (void *)spl_image->load_addr);
 		}
 		if (IS_ENABLED(CONFIG_SPI_FLASH_SOFT_RESET)) {
 			err = spi_nor_remove(flash);
@@ -974,9 +974,18 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * Like Linux and Mac OS X, allow larger transfers for SuperSpeed
+	 * devices, where the CBW/CSW round trip of each command otherwise
+	 * leaves most of the bandwidth unused.
 	 */
 	unsigned short blk = 240;
 
+#ifdef CONFIG_USB_STORAGE_SS_MAX_XFER_BLK
+	if (udev->speed >= USB_SPEED_SUPER)
+		blk = CONFIG_USB_STORAGE_SS_MAX_XFER_BLK;
+#endif
+
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
 	int ret;
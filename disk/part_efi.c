@@ -52,7 +52,8 @@ static inline u32 efi_crc32(const void *buf, u32 len)
 static int pmbr_part_valid(struct partition *part);
 static int is_pmbr_valid(legacy_mbr * mbr);
 static int is_gpt_valid(struct blk_desc *dev_desc, u64 lba,
-				gpt_header *pgpt_head, gpt_entry **pgpt_pte);
+				gpt_header *pgpt_head, gpt_entry **pgpt_pte,
+				bool use_cache);
 static gpt_entry *alloc_read_gpt_entries(struct blk_desc *dev_desc,
 					 gpt_header *pgpt_head);
 static int is_pte_valid(gpt_entry * pte);
@@ -186,6 +187,133 @@ static void prepare_backup_gpt_header(gpt_header *gpt_h)
 	gpt_h->header_crc32 = cpu_to_le32(calc_crc32);
 }
 
+/* Number of GPTs whose entries are kept */
+#define GPT_CACHE_SIZE	4
+
+/**
+ * struct gpt_cache_entry - Partition entries of a GPT read earlier
+ *
+ * @uclass_id: Uclass of the block device the GPT was read from
+ * @devnum: Device number of the block device
+ * @hwpart: Hardware partition of the block device
+ * @head: GPT header, including the CRC of @pte
+ * @pte: Partition entries, NULL if the entry is free
+ * @size: Size of @pte in bytes
+ *
+ * Entries are discarded by gpt_cache_invalidate() when the block device is
+ * written or removed.
+ */
+struct gpt_cache_entry {
+	enum uclass_id uclass_id;
+	int devnum;
+	int hwpart;
+	gpt_header head;
+	gpt_entry *pte;
+	size_t size;
+};
+
+static struct gpt_cache_entry gpt_cache[GPT_CACHE_SIZE];
+static int gpt_cache_next;
+
+static bool gpt_cache_match(struct gpt_cache_entry *ent,
+			    struct blk_desc *dev_desc, gpt_header *gpt_h)
+{
+	return ent->pte && ent->uclass_id == dev_desc->uclass_id &&
+		ent->devnum == dev_desc->devnum &&
+		ent->hwpart == dev_desc->hwpart &&
+		ent->head.my_lba == gpt_h->my_lba;
+}
+
+/**
+ * gpt_cache_get() - Get a copy of the entries of a GPT read earlier
+ *
+ * @dev_desc: Block device
+ * @gpt_h: Valid GPT header just read from @dev_desc
+ * Return: copy of the entries, which the caller must free, or NULL if the
+ *	GPT is not in the cache
+ */
+static gpt_entry *gpt_cache_get(struct blk_desc *dev_desc, gpt_header *gpt_h)
+{
+	struct gpt_cache_entry *ent;
+	gpt_entry *pte;
+
+	if (!CONFIG_IS_ENABLED(EFI_PARTITION_CACHE))
+		return NULL;
+
+	for (ent = gpt_cache; ent < gpt_cache + GPT_CACHE_SIZE; ent++) {
+		if (!gpt_cache_match(ent, dev_desc, gpt_h) ||
+		    memcmp(&ent->head, gpt_h, sizeof(*gpt_h)))
+			continue;
+		pte = memalign(ARCH_DMA_MINALIGN, ent->size);
+		if (!pte)
+			return NULL;
+		memcpy(pte, ent->pte, ent->size);
+
+		return pte;
+	}
+
+	return NULL;
+}
+
+/**
+ * gpt_cache_put() - Keep the entries of a GPT which has been checked
+ *
+ * @dev_desc: Block device
+ * @gpt_h: Valid GPT header read from @dev_desc
+ * @pte: Valid entries for @gpt_h, as read by alloc_read_gpt_entries()
+ */
+static void gpt_cache_put(struct blk_desc *dev_desc, gpt_header *gpt_h,
+			  gpt_entry *pte)
+{
+	struct gpt_cache_entry *ent;
+	size_t size;
+	void *copy;
+
+	if (!CONFIG_IS_ENABLED(EFI_PARTITION_CACHE))
+		return;
+
+	size = PAD_TO_BLOCKSIZE(le32_to_cpu(gpt_h->num_partition_entries) *
+				le32_to_cpu(gpt_h->sizeof_partition_entry),
+				dev_desc);
+	copy = malloc(size);
+	if (!copy)
+		return;
+	memcpy(copy, pte, size);
+
+	/* Replace an older GPT from the same place, else the oldest entry */
+	for (ent = gpt_cache; ent < gpt_cache + GPT_CACHE_SIZE; ent++) {
+		if (gpt_cache_match(ent, dev_desc, gpt_h))
+			break;
+	}
+	if (ent == gpt_cache + GPT_CACHE_SIZE) {
+		ent = &gpt_cache[gpt_cache_next];
+		gpt_cache_next = (gpt_cache_next + 1) % GPT_CACHE_SIZE;
+	}
+
+	free(ent->pte);
+	ent->uclass_id = dev_desc->uclass_id;
+	ent->devnum = dev_desc->devnum;
+	ent->hwpart = dev_desc->hwpart;
+	memcpy(&ent->head, gpt_h, sizeof(*gpt_h));
+	ent->pte = copy;
+	ent->size = size;
+}
+
+#if CONFIG_IS_ENABLED(EFI_PARTITION_CACHE)
+void gpt_cache_invalidate(int uclass_id, int devnum)
+{
+	struct gpt_cache_entry *ent;
+
+	for (ent = gpt_cache; ent < gpt_cache + GPT_CACHE_SIZE; ent++) {
+		if (uclass_id != -1 &&
+		    (ent->uclass_id != uclass_id || ent->devnum != devnum))
+			continue;
+		free(ent->pte);
+		ent->pte = NULL;
+	}
+}
+#endif
+
 #if CONFIG_IS_ENABLED(EFI_PARTITION)
 /*
  * Public Functions (include/part.h)
@@ -673,7 +801,7 @@ int gpt_verify_headers(struct blk_desc *dev_desc, gpt_header *gpt_head,
 	 */
 	if (is_gpt_valid(dev_desc,
 			 GPT_PRIMARY_PARTITION_TABLE_LBA,
-			 gpt_head, gpt_pte) != 1) {
+			 gpt_head, gpt_pte, false) != 1) {
 		log_debug("Invalid GPT\n");
 		return -1;
 	}
@@ -690,7 +818,7 @@ int gpt_verify_headers(struct blk_desc *dev_desc, gpt_header *gpt_head,
 	}
 
 	if (is_gpt_valid(dev_desc, (dev_desc->lba - 1),
-			 gpt_head, gpt_pte) != 1) {
+			 gpt_head, gpt_pte, false) != 1) {
 		log_debug("Invalid Backup GPT\n");
 		return -1;
 	}
@@ -749,9 +877,9 @@ int gpt_repair_headers(struct blk_desc *dev_desc)
 	int ret = -1;
 
 	is_gpt1_valid = is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-				     gpt_h1, &gpt_e1);
+				     gpt_h1, &gpt_e1, false);
 	is_gpt2_valid = is_gpt_valid(dev_desc, dev_desc->lba - 1,
-				     gpt_h2, &gpt_e2);
+				     gpt_h2, &gpt_e2, false);
 
 	if (is_gpt1_valid && is_gpt2_valid) {
 		ret = 0;
@@ -1004,12 +1132,15 @@ static int is_pmbr_valid(legacy_mbr * mbr)
  * lba is the logical block address of the GPT header to test
  * gpt is a GPT header ptr, filled on return.
  * ptes is a PTEs ptr, filled on return.
+ * use_cache allows taking the PTEs from the GPT cache if the header matches,
+ * instead of reading and checking them. Only lookups may do this.
  *
  * Description: returns 1 if valid,  0 on error, 2 if ignored header
  * If valid, returns pointers to PTEs.
  */
 static int is_gpt_valid(struct blk_desc *dev_desc, u64 lba,
-			gpt_header *pgpt_head, gpt_entry **pgpt_pte)
+			gpt_header *pgpt_head, gpt_entry **pgpt_pte,
+			bool use_cache)
 {
 	/* Confirm valid arguments prior to allocation. */
 	if (!dev_desc || !pgpt_head) {
@@ -1017,14 +1148,6 @@ static int is_gpt_valid(struct blk_desc *dev_desc, u64 lba,
 		return 0;
 	}
 
-	ALLOC_CACHE_ALIGN_BUFFER_PAD(legacy_mbr, mbr, 1, dev_desc->blksz);
-
-	/* Read MBR Header from device */
-	if (blk_dread(dev_desc, 0, 1, (ulong *)mbr) != 1) {
-		log_debug("Can't read MBR header\n");
-		return 0;
-	}
-
 	/* Read GPT Header from device */
 	if (blk_dread(dev_desc, (lbaint_t)lba, 1, pgpt_head) != 1) {
 		log_debug("Can't read GPT header\n");
@@ -1046,12 +1169,29 @@ static int is_gpt_valid(struct blk_desc *dev_desc, u64 lba,
 			dev_desc->sig_type = SIG_TYPE_GUID;
 			memcpy(&dev_desc->guid_sig, &pgpt_head->disk_guid,
 			      sizeof(empty));
-		} else if (mbr->unique_mbr_signature != 0) {
-			dev_desc->sig_type = SIG_TYPE_MBR;
-			dev_desc->mbr_sig = mbr->unique_mbr_signature;
+		} else {
+			ALLOC_CACHE_ALIGN_BUFFER_PAD(legacy_mbr, mbr, 1,
+						     dev_desc->blksz);
+
+			/* Read MBR Header from device */
+			if (blk_dread(dev_desc, 0, 1, (ulong *)mbr) != 1) {
+				log_debug("Can't read MBR header\n");
+				return 0;
+			}
+			if (mbr->unique_mbr_signature != 0) {
+				dev_desc->sig_type = SIG_TYPE_MBR;
+				dev_desc->mbr_sig = mbr->unique_mbr_signature;
+			}
 		}
 	}
 
+	/* The header holds the CRC of the entries, so they are unchanged */
+	if (use_cache) {
+		*pgpt_pte = gpt_cache_get(dev_desc, pgpt_head);
+		if (*pgpt_pte)
+			return 1;
+	}
+
 	/* Read and allocate Partition Table Entries */
 	*pgpt_pte = alloc_read_gpt_entries(dev_desc, pgpt_head);
 	if (!*pgpt_pte)
@@ -1061,6 +1201,7 @@ static int is_gpt_valid(struct blk_desc *dev_desc, u64 lba,
 		free(*pgpt_pte);
 		return 0;
 	}
+	gpt_cache_put(dev_desc, pgpt_head, *pgpt_pte);
 
 	/* We're done, all's well */
 	return 1;
@@ -1081,14 +1222,14 @@ static int find_valid_gpt(struct blk_desc *dev_desc, gpt_header *gpt_head,
 	int r;
 
 	r = is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA, gpt_head,
-			 pgpt_pte);
+			 pgpt_pte, true);
 
 	if (r != 1) {
 		if (r != 2)
 			log_debug("Invalid GPT\n");
 
 		if (is_gpt_valid(dev_desc, (dev_desc->lba - 1), gpt_head,
-				 pgpt_pte) != 1) {
+				 pgpt_pte, true) != 1) {
 			log_debug("Invalid Backup GPT\n");
 			return 0;
 		}
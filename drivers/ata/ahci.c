@@ -56,6 +56,7 @@ struct ahci_uc_priv *probe_ent = NULL;
 #define WAIT_MS_LINKUP	200
 
 #define AHCI_CAP_S64A BIT(31)
+#define AHCI_CAP_SNCQ BIT(30)
 
 __weak void __iomem *ahci_port_base(void __iomem *base, u32 port)
 {
@@ -448,11 +449,9 @@ static int ahci_init_one(struct ahci_uc_priv *uc_priv, struct udevice *dev)
 
 #define MAX_DATA_BYTE_COUNT  (4*1024*1024)
 
-static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
+static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, struct ahci_sg *ahci_sg,
 			unsigned char *buf, int buf_len)
 {
-	struct ahci_ioports *pp = &(uc_priv->port[port]);
-	struct ahci_sg *ahci_sg = pp->cmd_tbl_sg;
 	phys_addr_t pa = virt_to_phys(buf);
 	u32 sg_count;
 	int i;
@@ -482,18 +481,25 @@ static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
 	return sg_count;
 }
 
-static void ahci_fill_cmd_slot(struct ahci_ioports *pp, u32 opts)
+static void ahci_fill_cmd_slot_tag(struct ahci_ioports *pp, int tag,
+				   ulong tbl, u32 opts)
 {
-	phys_addr_t pa = virt_to_phys((void *)pp->cmd_tbl);
+	struct ahci_cmd_hdr *cmd_slot = pp->cmd_slot + tag;
+	phys_addr_t pa = virt_to_phys((void *)tbl);
 
-	pp->cmd_slot->opts = cpu_to_le32(opts);
-	pp->cmd_slot->status = 0;
-	pp->cmd_slot->tbl_addr = cpu_to_le32(lower_32_bits(pa));
+	cmd_slot->opts = cpu_to_le32(opts);
+	cmd_slot->status = 0;
+	cmd_slot->tbl_addr = cpu_to_le32(lower_32_bits(pa));
 #ifdef CONFIG_PHYS_64BIT
-	pp->cmd_slot->tbl_addr_hi = cpu_to_le32(upper_32_bits(pa));
+	cmd_slot->tbl_addr_hi = cpu_to_le32(upper_32_bits(pa));
 #endif
 }
 
+static void ahci_fill_cmd_slot(struct ahci_ioports *pp, u32 opts)
+{
+	ahci_fill_cmd_slot_tag(pp, 0, pp->cmd_tbl, opts);
+}
+
 static int wait_spinup(void __iomem *port_mmio)
 {
 	ulong start;
@@ -540,7 +546,7 @@ static int ahci_port_start(struct ahci_uc_priv *uc_priv, u8 port)
 	pp->cmd_slot =
 		(struct ahci_cmd_hdr *)(uintptr_t)virt_to_phys((void *)mem);
 	debug("cmd_slot = %p\n", pp->cmd_slot);
-	mem += (AHCI_CMD_SLOT_SZ + 224);
+	mem += AHCI_CMD_SLOT_SZ * AHCI_MAX_CMD_SLOT;
 
 	/*
 	 * Second item: Received-FIS area
@@ -609,7 +615,7 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, fis_len);
 
-	sg_count = ahci_fill_sg(uc_priv, port, buf, buf_len);
+	sg_count = ahci_fill_sg(uc_priv, pp->cmd_tbl_sg, buf, buf_len);
 	opts = (fis_len >> 2) | (sg_count << 16) | (is_write << 6);
 	ahci_fill_cmd_slot(pp, opts);
 
@@ -632,6 +638,173 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 	return 0;
 }
 
+/*
+ * Enable NCQ on a port if both the controller and the device support it,
+ * using as many tags as both of them allow. Called once the device has been
+ * identified.
+ */
+static void ahci_ncq_setup(struct ahci_uc_priv *uc_priv, u8 port)
+{
+	struct ahci_ioports *pp = &(uc_priv->port[port]);
+	u16 *id = uc_priv->ataid[port];
+	u32 depth;
+	void *mem;
+
+	pp->ncq_depth = 0;
+	if (!IS_ENABLED(CONFIG_SCSI_AHCI_NCQ) ||
+	    !(uc_priv->cap & AHCI_CAP_SNCQ) || !ata_id_has_ncq(id))
+		return;
+
+	/* Both values are encoded as 'number of tags - 1' */
+	depth = min(((uc_priv->cap >> 8) & 0x1f) + 1,
+		    (id[ATA_ID_QUEUE_DEPTH] & 0x1f) + 1U);
+	if (depth < 2)
+		return;
+
+	if (!pp->ncq_tbl) {
+		/* Command tables must be 128-byte aligned */
+		mem = memalign(128, AHCI_MAX_CMD_SLOT * AHCI_CMD_TBL_SZ);
+		if (!mem) {
+			debug("%s: No mem for NCQ tables\n", __func__);
+			return;
+		}
+		memset(mem, 0, AHCI_MAX_CMD_SLOT * AHCI_CMD_TBL_SZ);
+		pp->ncq_tbl = virt_to_phys(mem);
+	}
+	pp->ncq_depth = depth;
+	debug("Port %d: NCQ with %d tags\n", port, depth);
+}
+
+/*
+ * Bring a port back after a failed queued command: the controller stops
+ * processing the command list on error, so restart it with a clean slate.
+ */
+static void ahci_ncq_recover(struct ahci_ioports *pp)
+{
+	void __iomem *port_mmio = pp->port_mmio;
+	u32 cmd;
+
+	cmd = readl(port_mmio + PORT_CMD);
+	writel_with_flush(cmd & ~PORT_CMD_START, port_mmio + PORT_CMD);
+	waiting_for_cmd_completed(port_mmio + PORT_CMD, 500, PORT_CMD_LIST_ON);
+
+	writel(readl(port_mmio + PORT_SCR_ERR), port_mmio + PORT_SCR_ERR);
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+	writel_with_flush(cmd | PORT_CMD_START, port_mmio + PORT_CMD);
+	wait_spinup(port_mmio);
+}
+
+/*
+ * Transfer @blocks sectors with FPDMA QUEUED commands of at most
+ * MAX_SATA_BLOCKS_READ_WRITE sectors each. Up to ncq_depth commands are
+ * outstanding at any time; a tag is reused as soon as SActive shows that
+ * its command has completed.
+ */
+static int ahci_ncq_read_write(struct ahci_uc_priv *uc_priv, u8 port,
+			       lbaint_t lba, u16 blocks, u8 *buf, u8 is_write)
+{
+	struct ahci_ioports *pp = &(uc_priv->port[port]);
+	void __iomem *port_mmio = pp->port_mmio;
+	ulong len = (ulong)blocks * ATA_SECT_SIZE;
+	u8 *start_buf = buf;
+	u32 active = 0;
+	u32 sactive;
+	ulong start;
+	int tag;
+
+	/*
+	 * Status left over from earlier non-queued commands must not be
+	 * taken as an NCQ error below
+	 */
+	writel(readl(port_mmio + PORT_SCR_ERR), port_mmio + PORT_SCR_ERR);
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+
+	ahci_dcache_flush_range((unsigned long)buf, len);
+	start = get_timer(0);
+	while (blocks || active) {
+		for (tag = 0; blocks && tag < pp->ncq_depth; tag++) {
+			u16 now_blocks;
+			ulong tbl;
+			u8 *fis;
+			int sg_count;
+
+			if (active & BIT(tag))
+				continue;
+
+			now_blocks = min((u16)MAX_SATA_BLOCKS_READ_WRITE,
+					 blocks);
+			tbl = pp->ncq_tbl + tag * AHCI_CMD_TBL_SZ;
+
+			fis = (u8 *)tbl;
+			memset(fis, 0, 20);
+			fis[0] = 0x27;		/* Host to device FIS. */
+			fis[1] = 1 << 7;	/* Command FIS. */
+			fis[2] = is_write ? ATA_CMD_FPDMA_WRITE :
+					    ATA_CMD_FPDMA_READ;
+			/* Sector count goes in the features registers */
+			fis[3] = (now_blocks >> 0) & 0xff;
+			fis[11] = (now_blocks >> 8) & 0xff;
+			fis[4] = (lba >> 0) & 0xff;
+			fis[5] = (lba >> 8) & 0xff;
+			fis[6] = (lba >> 16) & 0xff;
+			fis[7] = 1 << 6; /* device reg: set LBA mode */
+			fis[8] = (lba >> 24) & 0xff;
+#ifdef CONFIG_SYS_64BIT_LBA
+			fis[9] = (lba >> 32) & 0xff;
+			fis[10] = (lba >> 40) & 0xff;
+#endif
+			/* ... and the tag in the sector count register */
+			fis[12] = tag << 3;
+
+			sg_count = ahci_fill_sg(uc_priv,
+					(struct ahci_sg *)(tbl + AHCI_CMD_TBL_HDR),
+					buf, now_blocks * ATA_SECT_SIZE);
+			if (sg_count < 0)
+				goto err;
+			ahci_fill_cmd_slot_tag(pp, tag, tbl, 5 |
+					       (sg_count << 16) |
+					       (is_write << 6));
+			ahci_dcache_flush_range((unsigned long)pp->cmd_slot,
+						AHCI_CMD_SLOT_SZ *
+						AHCI_MAX_CMD_SLOT);
+			ahci_dcache_flush_range(tbl, AHCI_CMD_TBL_SZ);
+
+			/* SActive must be set before the command is issued */
+			writel_with_flush(BIT(tag), port_mmio + PORT_SCR_ACT);
+			writel_with_flush(BIT(tag), port_mmio + PORT_CMD_ISSUE);
+			active |= BIT(tag);
+
+			buf += now_blocks * ATA_SECT_SIZE;
+			lba += now_blocks;
+			blocks -= now_blocks;
+		}
+
+		if (readl(port_mmio + PORT_IRQ_STAT) & PORT_IRQ_FATAL) {
+			printf("scsi_ahci: NCQ error on port %d\n", port);
+			goto err;
+		}
+
+		sactive = readl(port_mmio + PORT_SCR_ACT) & active;
+		if (sactive != active) {
+			/* Some commands completed, restart the timeout */
+			active = sactive;
+			start = get_timer(0);
+		} else if (get_timer(start) > WAIT_MS_DATAIO) {
+			printf("scsi_ahci: NCQ timeout on port %d\n", port);
+			goto err;
+		}
+	}
+
+	ahci_dcache_invalidate_range((unsigned long)start_buf, len);
+
+	return 0;
+
+err:
+	ahci_ncq_recover(pp);
+
+	return -EIO;
+}
+
 static char *ata_id_strcpy(u16 *target, u16 *src, int len)
 {
 	int i;
@@ -699,6 +872,7 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 
 	memcpy(idbuf, tmpid, ATA_ID_WORDS * 2);
 	ata_swap_buf_le16(idbuf, ATA_ID_WORDS);
+	ahci_ncq_setup(uc_priv, port);
 
 	memcpy(&pccb->pdata[8], "ATA     ", 8);
 	ata_id_strcpy((u16 *)&pccb->pdata[16], &idbuf[ATA_ID_PROD], 16);
@@ -717,6 +891,7 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 				 struct scsi_cmd *pccb, u8 is_write)
 {
+	struct ahci_ioports *pp;
 	lbaint_t lba = 0;
 	u16 blocks = 0;
 	u8 fis[20];
@@ -752,6 +927,20 @@ static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 	debug("scsi_ahci: %s %u blocks starting from lba 0x" LBAFU "\n",
 	      is_write ?  "write" : "read", blocks, lba);
 
+	/*
+	 * Queue transfers which need more than one command, if possible. If
+	 * that fails, drop back to one command at a time for this port.
+	 */
+	pp = &uc_priv->port[pccb->target];
+	if (pp->ncq_depth && blocks > MAX_SATA_BLOCKS_READ_WRITE &&
+	    user_buffer_size >= blocks * ATA_SECT_SIZE) {
+		if (!ahci_ncq_read_write(uc_priv, pccb->target, lba, blocks,
+					 user_buffer, is_write))
+			return is_write ? ata_io_flush(uc_priv, pccb->target) :
+					  0;
+		pp->ncq_depth = 0;
+	}
+
 	/* Preset the FIS */
 	memset(fis, 0, sizeof(fis));
 	fis[0] = 0x27;		 /* Host to device FIS. */
@@ -297,6 +297,8 @@ static int apple_dart_remove(struct udevice *dev)
 	}
 	priv->flush_tlb(priv);
 
+	lmb_uninit(&priv->lmb);
+
 	return 0;
 }
 
@@ -27,6 +27,7 @@
 #include "mmc_private.h"
 
 #define DEFAULT_CMD6_TIMEOUT_MS  500
+#define MMC_CACHE_FLUSH_TIMEOUT_MS	30000
 
 static int mmc_set_signal_voltage(struct mmc *mmc, uint signal_voltage);
 
@@ -398,11 +399,36 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 }
 #endif
 
+bool mmc_can_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	if (!(mmc->host_caps & MMC_CAP_CMD23) || mmc_host_is_spi(mmc))
+		return false;
+
+	/* The block count is a 16-bit field */
+	if (blkcnt < 2 || blkcnt > 0xffff)
+		return false;
+
+	if (IS_SD(mmc))
+		return mmc->scr[0] & SD_SCR_CMD23_SUPPORT;
+
+	return mmc->version >= MMC_VERSION_3;
+}
+
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 			   lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	bool sbc;
+
+	sbc = mmc_can_set_block_count(mmc, blkcnt);
+	if (sbc) {
+		cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+		cmd.cmdarg = blkcnt;
+		cmd.resp_type = MMC_RSP_R1;
+		if (mmc_send_cmd(mmc, &cmd, NULL))
+			return 0;
+	}
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -421,10 +447,18 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	data.blocksize = mmc->read_bl_len;
 	data.flags = MMC_DATA_READ;
 
-	if (mmc_send_cmd(mmc, &cmd, &data))
+	if (mmc_send_cmd(mmc, &cmd, &data)) {
+		/* A pre-defined transfer may not have completed, abort it */
+		if (sbc) {
+			cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+			cmd.cmdarg = 0;
+			cmd.resp_type = MMC_RSP_R1b;
+			mmc_send_cmd(mmc, &cmd, NULL);
+		}
 		return 0;
+	}
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -796,6 +830,9 @@ static int __mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value,
 	int timeout_ms = DEFAULT_CMD6_TIMEOUT_MS;
 	bool is_part_switch = (set == EXT_CSD_CMD_SET_NORMAL) &&
 			      (index == EXT_CSD_PART_CONF);
+	bool is_cache_flush = (set == EXT_CSD_CMD_SET_NORMAL) &&
+			      (index == EXT_CSD_FLUSH_CACHE ||
+			       index == EXT_CSD_CACHE_CTRL);
 	int ret;
 
 	if (mmc->gen_cmd6_time)
@@ -804,6 +841,10 @@ static int __mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value,
 	if (is_part_switch  && mmc->part_switch_time)
 		timeout_ms = mmc->part_switch_time * 10;
 
+	/* Flushing the cache (also on disabling it) has no specified limit */
+	if (is_cache_flush)
+		timeout_ms = MMC_CACHE_FLUSH_TIMEOUT_MS;
+
 	cmd.cmdidx = MMC_CMD_SWITCH;
 	cmd.resp_type = MMC_RSP_R1b;
 	cmd.cmdarg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) |
@@ -1207,6 +1248,8 @@ int mmc_hwpart_config(struct mmc *mmc,
 		/* update erase group size to be high-capacity */
 		mmc->erase_grp_size =
 			ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024;
+		mmc->erase_timeout_ms =
+			ext_csd[EXT_CSD_ERASE_TIMEOUT_MULT] * 300;
 #endif
 
 	}
@@ -2398,6 +2441,8 @@ static int mmc_startup_v4(struct mmc *mmc)
 		/* Read out group size from ext_csd */
 		mmc->erase_grp_size =
 			ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024;
+		mmc->erase_timeout_ms =
+			ext_csd[EXT_CSD_ERASE_TIMEOUT_MULT] * 300;
 #endif
 		/*
 		 * if high capacity and partition setting completed
@@ -2435,6 +2480,17 @@ static int mmc_startup_v4(struct mmc *mmc)
 	mmc->can_trim =
 		!!(ext_csd[EXT_CSD_SEC_FEATURE] & EXT_CSD_SEC_FEATURE_TRIM_EN);
 
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+	/* The volatile cache was introduced with eMMC 4.5 */
+	if (mmc->version >= MMC_VERSION_4_5)
+		mmc->cache_size = ext_csd[EXT_CSD_CACHE_SIZE] |
+				  ext_csd[EXT_CSD_CACHE_SIZE + 1] << 8 |
+				  ext_csd[EXT_CSD_CACHE_SIZE + 2] << 16 |
+				  ext_csd[EXT_CSD_CACHE_SIZE + 3] << 24;
+	else
+		mmc->cache_size = 0;
+#endif
+
 	return 0;
 error:
 	if (mmc->ext_csd) {
@@ -2602,6 +2658,7 @@ static int mmc_startup(struct mmc *mmc)
 	 */
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	mmc->erase_grp_size = 1;
+	mmc->erase_timeout_ms = 0;
 #endif
 	mmc->part_config = MMCPART_NOAVAILABLE;
 
@@ -132,4 +132,19 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num);
  */
 int mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value);
 
+/**
+ * mmc_can_set_block_count() - Check if a transfer can use CMD23
+ *
+ * Multi-block transfers announced up front with SET_BLOCK_COUNT (CMD23)
+ * end by themselves, saving the STOP_TRANSMISSION (CMD12) round trip and
+ * its busy wait on every request. This needs a host with MMC_CAP_CMD23,
+ * i.e. one which does not send CMD12 by itself after each transfer, and a
+ * card supporting CMD23.
+ *
+ * @mmc:	MMC device
+ * @blkcnt:	Number of blocks to transfer
+ * Return: true if CMD23 should be sent before the transfer
+ */
+bool mmc_can_set_block_count(struct mmc *mmc, lbaint_t blkcnt);
+
 #endif /* _MMC_PRIVATE_H_ */
@@ -15,7 +15,11 @@
 #include <linux/math64.h>
 #include "mmc_private.h"
 
-static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt, u32 args)
+/* Time allowed for erasing one erase group */
+#define MMC_ERASE_GRP_TIMEOUT_MS	1000
+
+static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt, u32 args,
+			 bool busy)
 {
 	struct mmc_cmd cmd;
 	ulong end;
@@ -53,7 +57,7 @@ static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt, u32 args
 
 	cmd.cmdidx = MMC_CMD_ERASE;
 	cmd.cmdarg = args ? args : MMC_ERASE_ARG;
-	cmd.resp_type = MMC_RSP_R1b;
+	cmd.resp_type = busy ? MMC_RSP_R1b : MMC_RSP_R1;
 
 	err = mmc_send_cmd(mmc, &cmd, NULL);
 	if (err)
@@ -66,6 +70,81 @@ err_out:
 	return err;
 }
 
+/*
+ * Erase a range with as few erase commands as possible and wait for each to
+ * complete.
+ *
+ * The card may take erase_timeout_ms for each erase group. A host which waits
+ * for the busy signal itself gives up after max_busy_timeout_ms, so each
+ * command covers only as many groups as fit in that time. If not even one
+ * group fits, the erase command is sent without a busy response and the whole
+ * range is erased at once, leaving the wait to mmc_poll_for_busy().
+ */
+static int mmc_erase_range(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+			   u32 args)
+{
+	uint grp_ms = mmc->erase_timeout_ms ?: MMC_ERASE_GRP_TIMEOUT_MS;
+	uint max_ms = mmc->cfg->max_busy_timeout_ms;
+	bool busy = !max_ms || max_ms >= grp_ms;
+	lbaint_t chunk, n;
+	u64 wait_ms;
+	int err;
+
+	if (max_ms && busy)
+		chunk = max_ms / grp_ms * mmc->erase_grp_size;
+	else
+		chunk = blkcnt;
+
+	while (blkcnt) {
+		n = min(blkcnt, chunk);
+		err = mmc_erase_t(mmc, start, n, args, busy);
+		if (err)
+			return err;
+
+		wait_ms = DIV_ROUND_UP_ULL((u64)n, mmc->erase_grp_size) * grp_ms;
+		err = mmc_poll_for_busy(mmc, min_t(u64, wait_ms, INT_MAX));
+		if (err)
+			return err;
+		start += n;
+		blkcnt -= n;
+	}
+
+	return 0;
+}
+
+/*
+ * eMMC erase: rather than one command per erase group, erase the
+ * group-aligned middle of the range with as few commands as the host's busy
+ * timeout allows and trim the unaligned head and tail (if the card supports
+ * trim).
+ */
+static ulong mmc_erase_coalesced(struct mmc *mmc, lbaint_t start,
+				 lbaint_t blkcnt, u32 start_rem, u32 erase_args)
+{
+	lbaint_t head = 0, mid, tail;
+	u32 tail_rem;
+
+	if (erase_args != MMC_TRIM_ARG)
+		return mmc_erase_range(mmc, start, blkcnt, erase_args) ?
+			0 : blkcnt;
+
+	if (start_rem)
+		head = min_t(lbaint_t, mmc->erase_grp_size - start_rem, blkcnt);
+	div_u64_rem(blkcnt - head, mmc->erase_grp_size, &tail_rem);
+	tail = tail_rem;
+	mid = blkcnt - head - tail;
+
+	if (head && mmc_erase_range(mmc, start, head, MMC_TRIM_ARG))
+		return 0;
+	if (mid && mmc_erase_range(mmc, start + head, mid, MMC_ERASE_ARG))
+		return head;
+	if (tail && mmc_erase_range(mmc, start + head + mid, tail,
+				    MMC_TRIM_ARG))
+		return head + mid;
+
+	return blkcnt;
+}
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_berase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 #else
@@ -80,7 +159,7 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	u32 start_rem, blkcnt_rem, erase_args = 0;
 	struct mmc *mmc = find_mmc_device(dev_num);
 	lbaint_t blk = 0, blk_r = 0;
-	int timeout_ms = 1000;
+	int timeout_ms = MMC_ERASE_GRP_TIMEOUT_MS;
 
 	if (!mmc)
 		return -1;
@@ -117,15 +196,19 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 		}
 	}
 
+	if (!IS_SD(mmc))
+		return mmc_erase_coalesced(mmc, start, blkcnt, start_rem,
+					   erase_args);
+
 	while (blk < blkcnt) {
-		if (IS_SD(mmc) && mmc->ssr.au) {
+		if (mmc->ssr.au) {
 			blk_r = ((blkcnt - blk) > mmc->ssr.au) ?
 				mmc->ssr.au : (blkcnt - blk);
 		} else {
 			blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
 				mmc->erase_grp_size : (blkcnt - blk);
 		}
-		err = mmc_erase_t(mmc, start + blk, blk_r, erase_args);
+		err = mmc_erase_t(mmc, start + blk, blk_r, erase_args, true);
 		if (err)
 			break;
 
@@ -145,6 +228,7 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout_ms = 1000;
+	bool sbc;
 
 	if ((start + blkcnt) > mmc_get_blk_desc(mmc)->lba) {
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
@@ -154,7 +238,19 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 
 	if (blkcnt == 0)
 		return 0;
-	else if (blkcnt == 1)
+
+	sbc = mmc_can_set_block_count(mmc, blkcnt);
+	if (sbc) {
+		cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+		cmd.cmdarg = blkcnt;
+		cmd.resp_type = MMC_RSP_R1;
+		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+			printf("mmc fail to set block count\n");
+			return 0;
+		}
+	}
+
+	if (blkcnt == 1)
 		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
 	else
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
@@ -173,13 +269,21 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 
 	if (mmc_send_cmd(mmc, &cmd, &data)) {
 		printf("mmc write failed\n");
+		/* A pre-defined transfer may not have completed, abort it */
+		if (sbc) {
+			cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+			cmd.cmdarg = 0;
+			cmd.resp_type = MMC_RSP_R1b;
+			mmc_send_cmd(mmc, &cmd, NULL);
+		}
 		return 0;
 	}
 
 	/* SPI multiblock writes terminate using a special
-	 * token, not a STOP_TRANSMISSION request.
+	 * token, not a STOP_TRANSMISSION request. Pre-defined
+	 * multiblock writes (CMD23) terminate by themselves.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -196,6 +300,16 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	return blkcnt;
 }
 
+/*
+ * Enable or disable the eMMC volatile cache. Disabling it also flushes
+ * any data still held in it to the flash.
+ */
+static int mmc_set_cache(struct mmc *mmc, bool enable)
+{
+	return mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CACHE_CTRL,
+			  enable);
+}
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bwrite(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		 const void *src)
@@ -209,6 +323,8 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 #endif
 	int dev_num = block_dev->devnum;
 	lbaint_t cur, blocks_todo = blkcnt;
+	bool use_cache;
+	u32 rem;
 	int err;
 
 	struct mmc *mmc = find_mmc_device(dev_num);
@@ -222,15 +338,42 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
+	/*
+	 * Bulk writes (more than one host transfer) go through the eMMC
+	 * volatile cache, which is flushed and disabled again once done so
+	 * that nothing is left cached behind the back of later users.
+	 */
+	use_cache = IS_ENABLED(CONFIG_MMC_WRITE_CACHE) && !IS_SD(mmc) &&
+		    mmc->cache_size && blkcnt > mmc->cfg->b_max;
+	if (use_cache && mmc_set_cache(mmc, true))
+		use_cache = false;
+
 	do {
 		cur = (blocks_todo > mmc->cfg->b_max) ?
 			mmc->cfg->b_max : blocks_todo;
-		if (mmc_write_blocks(mmc, start, cur, src) != cur)
-			return 0;
+		/*
+		 * If more chunks follow, end this one on an erase-group
+		 * boundary so that the card does not have to merge partial
+		 * groups across transfers.
+		 */
+		if (cur < blocks_todo && mmc->erase_grp_size > 1) {
+			div_u64_rem(start + cur, mmc->erase_grp_size, &rem);
+			if (rem < cur)
+				cur -= rem;
+		}
+		if (mmc_write_blocks(mmc, start, cur, src) != cur) {
+			blkcnt = 0;
+			break;
+		}
 		blocks_todo -= cur;
 		start += cur;
 		src += cur * mmc->write_bl_len;
 	} while (blocks_todo > 0);
 
+	if (use_cache && mmc_set_cache(mmc, false)) {
+		printf("mmc cache flush failed\n");
+		return 0;
+	}
+
 	return blkcnt;
 }
@@ -13,6 +13,7 @@
 #include <mmc.h>
 #include <os.h>
 #include <asm/test.h>
+#include <asm/unaligned.h>
 
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
@@ -27,16 +28,25 @@ struct sandbox_mmc_plat {
 /* Granularity of priv->csize - this is 1MB */
 #define SIZE_MULTIPLE		((1 << (MMC_CMULT + 2)) * MMC_BL_LEN)
 
+/* eMMC emulation: 8MB card with 512KB erase groups, behind an sdhci-like host */
+#define EMMC_CSIZE		7
+#define EMMC_B_MAX		64
+#define EMMC_BUSY_TIMEOUT_MS	1000
+
 struct sandbox_mmc_priv {
 	char *buf;
 	int csize;	/* CSIZE value to report */
 	int size;
+	bool emmc;	/* emulate an eMMC rather than an SD card */
+	u8 ext_csd[MMC_MAX_BLOCK_LEN];
+	struct sandbox_mmc_counts counts;
 };
 
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
+ * This emulate an SD card version 2, or an eMMC 5.0 device once
+ * sandbox_mmc_set_emmc() is called. Single-block reads result in zero data.
  * Multiple-block reads return a test string.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
@@ -44,6 +54,7 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 {
 	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
 	static ulong erase_start, erase_end;
+	static uint block_count;
 
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
@@ -53,7 +64,18 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		cmd->response[0] = 0 << 16; /* mmc->rca */
 	case MMC_CMD_GO_IDLE_STATE:
 		break;
-	case SD_CMD_SEND_IF_COND:
+	case MMC_CMD_SEND_OP_COND:
+		if (!priv->emmc)
+			return -ETIMEDOUT;
+		cmd->response[0] = OCR_BUSY | OCR_HCS | OCR_VOLTAGE_MASK;
+		break;
+	case SD_CMD_SEND_IF_COND:	/* MMC_CMD_SEND_EXT_CSD on eMMC */
+		if (priv->emmc) {
+			if (!data)
+				return -ETIMEDOUT;
+			memcpy(data->dest, priv->ext_csd, sizeof(priv->ext_csd));
+			break;
+		}
 		cmd->response[0] = 0xaa;
 		break;
 	case MMC_CMD_SEND_STATUS:
@@ -62,13 +84,27 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case MMC_CMD_SELECT_CARD:
 		break;
 	case MMC_CMD_SEND_CSD:
-		cmd->response[0] = 0;
+		/* SPEC_VERS 4 tells an eMMC to read its EXT_CSD */
+		cmd->response[0] = priv->emmc ? 4 << 26 : 0;
 		cmd->response[1] = (MMC_BL_LEN_SHIFT << 16) |
 				   ((priv->csize >> 16) & 0x3f);
 		cmd->response[2] = (priv->csize & 0xffff) << 16;
 		cmd->response[3] = 0;
 		break;
-	case SD_CMD_SWITCH_FUNC: {
+	case SD_CMD_SWITCH_FUNC: {	/* MMC_CMD_SWITCH on eMMC */
+		if (priv->emmc) {
+			uint index = (cmd->cmdarg >> 16) & 0xff;
+			u8 value = (cmd->cmdarg >> 8) & 0xff;
+
+			if (index == EXT_CSD_CACHE_CTRL) {
+				if (value)
+					priv->counts.cache_on++;
+				else
+					priv->counts.cache_off++;
+			}
+			priv->ext_csd[index] = value;
+			break;
+		}
 		if (!data)
 			break;
 		u32 *resp = (u32 *)data->dest;
@@ -80,26 +116,49 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
+		/* A pre-defined transfer must match the announced size */
+		if (block_count && block_count != data->blocks) {
+			block_count = 0;
+			return -EIO;
+		}
+		block_count = 0;
 		memcpy(data->dest, &priv->buf[cmd->cmdarg * data->blocksize],
 		       data->blocks * data->blocksize);
 		break;
 	case MMC_CMD_WRITE_SINGLE_BLOCK:
 	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		/* A pre-defined transfer must match the announced size */
+		if (block_count && block_count != data->blocks) {
+			block_count = 0;
+			return -EIO;
+		}
+		block_count = 0;
 		memcpy(&priv->buf[cmd->cmdarg * data->blocksize], data->src,
 		       data->blocks * data->blocksize);
 		break;
+	case MMC_CMD_SET_BLOCK_COUNT:
+		block_count = cmd->cmdarg & 0xffff;
+		priv->counts.set_block_count++;
+		break;
 	case MMC_CMD_STOP_TRANSMISSION:
+		priv->counts.stop++;
 		break;
 	case SD_CMD_ERASE_WR_BLK_START:
+	case MMC_CMD_ERASE_GROUP_START:
 		erase_start = cmd->cmdarg;
 		break;
 	case SD_CMD_ERASE_WR_BLK_END:
+	case MMC_CMD_ERASE_GROUP_END:
 		erase_end = cmd->cmdarg;
 		break;
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	case MMC_CMD_ERASE: {
 		struct mmc *mmc = mmc_get_mmc_dev(dev);
 
+		priv->counts.erase++;
+		if (cmd->resp_type & MMC_RSP_BUSY)
+			priv->counts.erase_busy++;
+
 		memset(&priv->buf[erase_start * mmc->write_bl_len], '\0',
 		       (erase_end - erase_start + 1) * mmc->write_bl_len);
 		break;
@@ -111,6 +170,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		cmd->response[2] = 0;
 		break;
 	case MMC_CMD_APP_CMD:
+		if (priv->emmc)
+			return -ETIMEDOUT;
 		break;
 	case MMC_CMD_SET_BLOCKLEN:
 		debug("block len %d\n", cmd->cmdarg);
@@ -118,7 +179,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, supporting CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_SCR_CMD23_SUPPORT);
 		break;
 	}
 	default:
@@ -129,6 +191,56 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+int sandbox_mmc_set_emmc(struct udevice *dev, bool emmc)
+{
+	struct sandbox_mmc_plat *plat = dev_get_plat(dev);
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	u8 *ext_csd = priv->ext_csd;
+	int csize = emmc ? EMMC_CSIZE : 0;
+	int size = (csize + 1) * SIZE_MULTIPLE;
+	char *buf;
+
+	if (plat->fname)
+		return -EINVAL;
+	buf = calloc(1, size);
+	if (!buf)
+		return -ENOMEM;
+	free(priv->buf);
+	priv->buf = buf;
+	priv->csize = csize;
+	priv->size = size;
+	priv->emmc = emmc;
+	memset(&priv->counts, '\0', sizeof(priv->counts));
+
+	memset(ext_csd, '\0', sizeof(priv->ext_csd));
+	if (emmc) {
+		ext_csd[EXT_CSD_REV] = 7;
+		ext_csd[EXT_CSD_CARD_TYPE] = EXT_CSD_CARD_TYPE_26 |
+					     EXT_CSD_CARD_TYPE_52;
+		put_unaligned_le32(size / MMC_MAX_BLOCK_LEN,
+				   &ext_csd[EXT_CSD_SEC_CNT]);
+		ext_csd[EXT_CSD_ERASE_GROUP_DEF] = 1;
+		ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] = 1;
+		ext_csd[EXT_CSD_HC_WP_GRP_SIZE] = 1;
+		ext_csd[EXT_CSD_ERASE_TIMEOUT_MULT] = 1;
+		ext_csd[EXT_CSD_SEC_FEATURE] = EXT_CSD_SEC_FEATURE_TRIM_EN;
+		put_unaligned_le32(64, &ext_csd[EXT_CSD_CACHE_SIZE]);
+	}
+	plat->cfg.b_max = emmc ? EMMC_B_MAX : U32_MAX;
+	plat->cfg.max_busy_timeout_ms = emmc ? EMMC_BUSY_TIMEOUT_MS : 0;
+
+	plat->mmc.has_init = 0;
+
+	return mmc_init(&plat->mmc);
+}
+
+struct sandbox_mmc_counts *sandbox_mmc_get_counts(struct udevice *dev)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	return &priv->counts;
+}
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -213,7 +325,8 @@ static int sandbox_mmc_bind(struct udevice *dev)
 	struct mmc_config *cfg = &plat->cfg;
 
 	cfg->name = dev->name;
-	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT;
+	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT |
+			 MMC_CAP_CMD23;
 	cfg->voltages = MMC_VDD_165_195 | MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
@@ -967,7 +967,12 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 	if (caps & SDHCI_CAN_DO_HISPD)
 		cfg->host_caps |= MMC_MODE_HS | MMC_MODE_HS_52MHz;
 
-	cfg->host_caps |= MMC_MODE_4BIT;
+	/* CMD12 is sent by the MMC core, the controller never adds its own */
+	cfg->host_caps |= MMC_MODE_4BIT | MMC_CAP_CMD23;
+
+	/* sdhci_send_command() gives up on the busy signal after this long */
+	if (!(host->quirks & SDHCI_QUIRK_BROKEN_R1B))
+		cfg->max_busy_timeout_ms = SDHCI_READ_STATUS_TIMEOUT;
 
 	/* Since Host Controller Version3.0 */
 	if (SDHCI_GET_VERSION(host) >= SDHCI_SPEC_300) {
@@ -2316,6 +2316,59 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+/**
+ * nand_do_read_cache - [INTERN] Read whole pages with cache read commands
+ * @mtd: MTD device structure
+ * @chip: NAND chip descriptor
+ * @page: first page to read
+ * @npages: number of pages to read, all in the same block
+ * @buf: buffer to store the data
+ * @max_bitflips: updated with the maximum number of bitflips per ECC step
+ *
+ * After the first page has been loaded, every READ CACHE SEQUENTIAL command
+ * moves the previous page to the cache register and starts loading the next
+ * page from the array. Transferring a page thus overlaps with the array read
+ * of its successor. READ CACHE END transfers the last page without starting
+ * another array read.
+ *
+ * If a page cannot be corrected, the sequence is terminated and the number
+ * of pages read before is returned. The caller reads the failing page again
+ * through the regular path, which applies read retries.
+ *
+ * Returns the number of pages read or a negative error code.
+ */
+static int nand_do_read_cache(struct mtd_info *mtd, struct nand_chip *chip,
+			      int page, int npages, uint8_t *buf,
+			      unsigned int *max_bitflips)
+{
+	unsigned int ecc_failures = mtd->ecc_stats.failed;
+	int i, ret;
+
+	ret = nand_read_page_op(chip, page, 0, NULL, 0);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < npages; i++) {
+		chip->cmdfunc(mtd, i < npages - 1 ? NAND_CMD_READCACHESEQ :
+			      NAND_CMD_READCACHEEND, -1, -1);
+
+		ret = chip->ecc.read_page(mtd, chip, buf, 0, page + i);
+		if (ret < 0 || mtd->ecc_stats.failed != ecc_failures) {
+			/* Let the array read of the next page complete */
+			if (i < npages - 1)
+				chip->cmdfunc(mtd, NAND_CMD_READCACHEEND,
+					      -1, -1);
+			mtd->ecc_stats.failed = ecc_failures;
+			return ret < 0 ? ret : i;
+		}
+
+		*max_bitflips = max_t(unsigned int, *max_bitflips, ret);
+		buf += mtd->writesize;
+	}
+
+	return npages;
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -2339,6 +2392,11 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	unsigned int max_bitflips = 0;
 	int retry_mode = 0;
 	bool ecc_fail = false;
+	bool cache_read = NAND_HAS_CACHEREAD(chip) && !ops->oobbuf &&
+			  ops->mode != MTD_OPS_RAW;
+	bool cache_skip = false;
+	int ppb = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int npages;
 
 	chipnr = (int)(from >> chip->chip_shift);
 	chip->select_chip(mtd, chipnr);
@@ -2367,6 +2425,28 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		else
 			use_bufpoi = 0;
 
+		/* Pipeline reads of whole pages inside the current block */
+		npages = min_t(int, readlen >> chip->page_shift,
+			       ppb - (page & (ppb - 1)));
+		if (cache_read && !cache_skip && aligned && !use_bufpoi &&
+		    npages > 1) {
+			ret = nand_do_read_cache(mtd, chip, page, npages, buf,
+						 &max_bitflips);
+			if (ret < 0)
+				break;
+			if (ret < npages)
+				/* Read the failing page with retries */
+				cache_skip = true;
+			if (!ret)
+				continue;
+
+			bytes = ret << chip->page_shift;
+			buf += bytes;
+			realpage += ret - 1;
+			goto next_page;
+		}
+		cache_skip = false;
+
 		/* Is the current page in the buffer? */
 		if (realpage != chip->pagebuf || oob) {
 			bufpoi = use_bufpoi ? chip->buffers->databuf : buf;
@@ -2464,6 +2544,7 @@ read_retry:
 					     chip->pagebuf_bitflips);
 		}
 
+next_page:
 		readlen -= bytes;
 
 		/* Reset to retry mode 0 */
@@ -3964,6 +4045,9 @@ static int nand_flash_detect_onfi(struct mtd_info *mtd, struct nand_chip *chip)
 	if (onfi_feature(chip) & ONFI_FEATURE_16_BIT_BUS)
 		chip->options |= NAND_BUSWIDTH_16;
 
+	if (le16_to_cpu(p->opt_cmd) & ONFI_OPT_CMD_READ_CACHE)
+		chip->options |= NAND_CACHERD;
+
 	if (p->ecc_bits != 0xff) {
 		chip->ecc_strength_ds = p->ecc_bits;
 		chip->ecc_step_ds = 512;
@@ -5196,6 +5280,18 @@ int nand_scan_tail(struct mtd_info *mtd)
 		break;
 	}
 
+	/*
+	 * Cache reads need the generic large page command function, which
+	 * waits for the ready/busy pin after each command, and ECC read
+	 * functions which transfer the page from its start without issuing
+	 * commands of their own.
+	 */
+	if (!IS_ENABLED(CONFIG_SYS_NAND_CACHE_READ) ||
+	    chip->cmdfunc != nand_command_lp || !chip->dev_ready ||
+	    !nand_standard_page_accessors(ecc) ||
+	    ecc->mode == NAND_ECC_HW_OOB_FIRST)
+		chip->options &= ~NAND_CACHERD;
+
 	mtd->flash_node = chip->flash_node;
 	/* Fill in remaining MTD driver data */
 	mtd->type = nand_is_slc(chip) ? MTD_NANDFLASH : MTD_MLCNANDFLASH;
@@ -10,6 +10,7 @@
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <spi.h>
 #include <spi_flash.h>
 #include <asm/global_data.h>
@@ -24,6 +25,23 @@ int spi_flash_read_dm(struct udevice *dev, u32 offset, size_t len, void *buf)
 	return log_ret(sf_get_ops(dev)->read(dev, offset, len, buf));
 }
 
+int spi_flash_read_mmap(struct udevice *dev, const struct spi_flash_mmap *map,
+			u32 offset, size_t len, void *buf)
+{
+	void *src;
+
+	if (!map->size || offset < map->offset || len > map->size ||
+	    offset - map->offset > map->size - len)
+		return spi_flash_read_dm(dev, offset, len, buf);
+
+	src = map_sysmem(map->base + offset - map->offset, len);
+	if (src != buf)
+		memcpy(buf, src, len);
+	unmap_sysmem(src);
+
+	return 0;
+}
+
 int spi_flash_write_dm(struct udevice *dev, u32 offset, size_t len,
 		       const void *buf)
 {
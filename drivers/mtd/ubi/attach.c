@@ -832,6 +832,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi_io_read_hdrs(ubi, pnum);
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1241,15 +1242,27 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
+	/* Without the buffer the headers are simply read one by one */
+	err = 0;
+	ubi->hdrs_pnum = -1;
+	ubi->hdrs_buf = kmalloc(ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize,
+				GFP_KERNEL);
+
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
 		dbg_gen("process PEB %d", pnum);
 		err = scan_peb(ubi, ai, pnum, NULL, NULL);
 		if (err < 0)
-			goto out_vidh;
+			break;
 	}
 
+	kfree(ubi->hdrs_buf);
+	ubi->hdrs_buf = NULL;
+	ubi->hdrs_pnum = -1;
+	if (err < 0)
+		goto out_vidh;
+
 	ubi_msg(ubi, "scanning is finished");
 
 	/* Calculate mean erase counter */
@@ -132,6 +132,12 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	ubi_assert(offset >= 0 && offset + len <= ubi->peb_size);
 	ubi_assert(len > 0);
 
+	if (ubi->hdrs_buf && pnum == ubi->hdrs_pnum &&
+	    offset + len <= ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize) {
+		memcpy(buf, ubi->hdrs_buf + offset, len);
+		return 0;
+	}
+
 	err = self_check_not_bad(ubi, pnum);
 	if (err)
 		return err;
@@ -211,6 +217,30 @@ retry:
 	return err;
 }
 
+/**
+ * ubi_io_read_hdrs - read ahead the EC and VID headers of a PEB.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ *
+ * This function reads the start of physical eraseblock @pnum up to the end of
+ * the VID header with a single MTD request into @ubi->hdrs_buf. Subsequent
+ * header reads from @pnum are then served from that buffer instead of issuing
+ * one request per header. If the read reports anything but success, nothing
+ * is kept and the headers are read separately, so that errors are reported
+ * for the header they belong to.
+ */
+void ubi_io_read_hdrs(struct ubi_device *ubi, int pnum)
+{
+	int len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+
+	if (!ubi->hdrs_buf)
+		return;
+
+	ubi->hdrs_pnum = -1;
+	if (!ubi_io_read(ubi, ubi->hdrs_buf, pnum, 0, len))
+		ubi->hdrs_pnum = pnum;
+}
+
 /**
  * ubi_io_write - write data to a physical eraseblock.
  * @ubi: UBI device description object
@@ -242,6 +272,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	ubi_assert(offset % ubi->hdrs_min_io_size == 0);
 	ubi_assert(len > 0 && len % ubi->hdrs_min_io_size == 0);
 
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_pnum = -1;
+
 	if (ubi->ro_mode) {
 		ubi_err(ubi, "read-only mode");
 		return -EROFS;
@@ -322,6 +355,9 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 	dbg_io("erase PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
 
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_pnum = -1;
+
 	if (ubi->ro_mode) {
 		ubi_err(ubi, "read-only mode");
 		return -EROFS;
@@ -253,8 +253,23 @@ char *env_get_default(const char *name)
 	return NULL;
 }
 
+/*
+ * While set, the drivers load into and save from this copy of the stored
+ * environment and the hash table is left alone, see env_redirect()
+ */
+static env_t *env_redirected;
+
+void env_redirect(env_t *env)
+{
+	env_redirected = env;
+}
+
 void env_set_default(const char *s, int flags)
 {
+	/* A failed load must not reset the environment in use */
+	if (env_redirected)
+		return;
+
 	if (s) {
 		if ((flags & H_INTERACTIVE) == 0) {
 			printf("*** Warning - %s, "
@@ -312,6 +327,11 @@ int env_import(const char *buf, int check, int flags)
 		}
 	}
 
+	if (env_redirected) {
+		memcpy(env_redirected->data, ep->data, ENV_SIZE);
+		return 0;
+	}
+
 	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', flags, 0,
 			0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
@@ -409,11 +429,17 @@ int env_export(env_t *env_out)
 	char *res;
 	ssize_t	len;
 
-	res = (char *)env_out->data;
-	len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
-	if (len < 0) {
-		pr_err("Cannot export environment: errno = %d\n", errno);
-		return 1;
+	if (env_redirected) {
+		if (env_out != env_redirected)
+			memcpy(env_out->data, env_redirected->data, ENV_SIZE);
+	} else {
+		res = (char *)env_out->data;
+		len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
+		if (len < 0) {
+			pr_err("Cannot export environment: errno = %d\n",
+			       errno);
+			return 1;
+		}
 	}
 
 	env_out->crc = crc32(0, env_out->data, ENV_SIZE);
@@ -8,6 +8,8 @@
 #include <env.h>
 #include <env_internal.h>
 #include <log.h>
+#include <malloc.h>
+#include <search.h>
 #include <asm/global_data.h>
 #include <linux/bitops.h>
 #include <linux/bug.h>
@@ -308,6 +310,76 @@ int env_save(void)
 	return -ENODEV;
 }
 
+/*
+ * Set @varname to @value (or drop it if NULL) in the exported environment
+ * @env, i.e. in its list of var=value strings ending with an empty one
+ */
+static int env_patch(env_t *env, const char *varname, const char *value)
+{
+	char *data = (char *)env->data, *end = data + ENV_SIZE;
+	size_t len = strlen(varname);
+	char *p, *next;
+	size_t size;
+
+	for (p = data; p < end && *p; ) {
+		next = p + strnlen(p, end - p) + 1;
+		if (next > end)
+			return -EINVAL;
+		if (!strncmp(p, varname, len) && p[len] == '=') {
+			memmove(p, next, end - next);
+			memset(end - (next - p), '\0', next - p);
+		} else {
+			p = next;
+		}
+	}
+	if (!value)
+		return 0;
+
+	/* Add it at the end, keeping the terminating empty string */
+	size = len + 1 + strlen(value) + 1;
+	if (p + size >= end)
+		return -ENOSPC;
+	sprintf(p, "%s=%s", varname, value);
+	p[size] = '\0';
+
+	return 0;
+}
+
+int env_save_var(const char *varname, const char *value)
+{
+	struct env_driver *load, *save;
+	env_t *stored;
+	int ret;
+
+	load = env_driver_lookup(ENVOP_LOAD, gd->env_load_prio);
+	save = env_driver_lookup(ENVOP_SAVE, gd->env_load_prio);
+	if (!load || !save || !save->save || !env_has_inited(save->location))
+		return -ENODEV;
+
+	stored = malloc(sizeof(*stored));
+	if (!stored)
+		return -ENOMEM;
+
+	/* Change only this variable in what is stored */
+	env_redirect(stored);
+	ret = load->load();
+	if (ret == -ENOMSG)
+		printf("Stored environment has a bad CRC, not saving '%s'\n",
+		       varname);
+	if (!ret)
+		ret = env_patch(stored, varname, value);
+	if (!ret)
+		ret = save->save();
+	env_redirect(NULL);
+	free(stored);
+	if (ret) {
+		log_debug("Cannot save '%s' (err=%d)\n", varname, ret);
+		return ret;
+	}
+
+	return env_set(varname, value);
+}
+
 int env_erase(void)
 {
 	struct env_driver *drv;
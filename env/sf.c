@@ -37,6 +37,19 @@ static ulong env_new_offset	= CONFIG_ENV_OFFSET_REDUND;
 
 #endif /* CONFIG_ENV_OFFSET_REDUND */
 
+#ifdef CONFIG_ENV_SPI_LOG
+#if CONFIG_ENV_SPI_LOG_SIZE % CONFIG_ENV_SECT_SIZE || \
+	CONFIG_ENV_SPI_LOG_SIZE % CONFIG_ENV_SIZE
+#error CONFIG_ENV_SPI_LOG_SIZE must be a multiple of CONFIG_ENV_SECT_SIZE and CONFIG_ENV_SIZE
+#endif
+#define ENV_LOG_SIZE		CONFIG_ENV_SPI_LOG_SIZE
+#else
+#define ENV_LOG_SIZE		0
+#endif
+#define ENV_LOG_SLOTS		(ENV_LOG_SIZE / CONFIG_ENV_SIZE)
+/* Bytes read from the start of a slot to check whether it is in use */
+#define ENV_LOG_PROBE		(sizeof(uint32_t) + 1)
+
 DECLARE_GLOBAL_DATA_PTR;
 
 static int setup_flash_device(struct spi_flash **env_flash)
@@ -189,6 +202,115 @@ out:
 	return ret;
 }
 #else
+/* Check whether the first @len bytes of a slot in a log area are erased */
+static int env_sf_log_erased(struct spi_flash *env_flash, u32 offset,
+			     int slot, u8 *buf, int len)
+{
+	int ret, i;
+
+	ret = spi_flash_read(env_flash, offset + slot * CONFIG_ENV_SIZE, len,
+			     buf);
+	if (ret)
+		return ret;
+	for (i = 0; i < len; i++) {
+		if (buf[i] != 0xff)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Find the number of slots in use in a log area, i.e. the index of the last
+ * slot which is not erased, plus one. Slots are written in order, so this is
+ * the newest copy. If the erase of a full area is cut short, the erased slots
+ * are at the start and the newest copy is still the last one.
+ */
+static int env_sf_log_used(struct spi_flash *env_flash, u32 offset,
+			   int slots)
+{
+	u8 buf[ENV_LOG_PROBE];
+	int slot, ret;
+
+	for (slot = slots; slot > 0; slot--) {
+		ret = env_sf_log_erased(env_flash, offset, slot - 1, buf,
+					sizeof(buf));
+		if (ret < 0)
+			return ret;
+		if (!ret)
+			break;
+	}
+
+	return slot;
+}
+
+int env_sf_log_save(struct spi_flash *env_flash, u32 offset, int slots,
+		    env_t *env_new)
+{
+	int slot, ret;
+	u8 *buf;
+
+	slot = env_sf_log_used(env_flash, offset, slots);
+	if (slot < 0)
+		return slot;
+
+	/* A cut-short erase may leave data further into the next slot */
+	if (slot < slots) {
+		buf = malloc(CONFIG_ENV_SIZE);
+		if (!buf)
+			return -ENOMEM;
+		ret = env_sf_log_erased(env_flash, offset, slot, buf,
+					CONFIG_ENV_SIZE);
+		free(buf);
+		if (ret < 0)
+			return ret;
+		if (!ret)
+			slot = slots;
+	}
+
+	/* Start again once all slots are used */
+	if (slot == slots) {
+		puts("Erasing SPI flash...");
+		ret = spi_flash_erase(env_flash, offset,
+				      slots * CONFIG_ENV_SIZE);
+		if (ret)
+			return ret;
+		slot = 0;
+	}
+
+	puts("Writing to SPI flash...");
+	ret = spi_flash_write(env_flash, offset + slot * CONFIG_ENV_SIZE,
+			      CONFIG_ENV_SIZE, env_new);
+	if (ret)
+		return ret;
+	puts("done\n");
+
+	return 0;
+}
+
+int env_sf_log_load(struct spi_flash *env_flash, u32 offset, int slots,
+		    env_t *env)
+{
+	int slot, ret;
+
+	slot = env_sf_log_used(env_flash, offset, slots);
+	if (slot < 0)
+		return slot;
+
+	/* Use the newest copy which is intact, else let the CRC check fail */
+	for (slot = max(slot, 1) - 1; slot >= 0; slot--) {
+		ret = spi_flash_read(env_flash,
+				     offset + slot * CONFIG_ENV_SIZE,
+				     CONFIG_ENV_SIZE, env);
+		if (ret)
+			return ret;
+		if (crc32(0, env->data, ENV_SIZE) == env->crc)
+			break;
+	}
+
+	return 0;
+}
+
 static int env_sf_save(void)
 {
 	u32	saved_size = 0, saved_offset = 0, sector;
@@ -202,6 +324,14 @@ static int env_sf_save(void)
 	if (ret)
 		return ret;
 
+	if (IS_ENABLED(CONFIG_ENV_SPI_LOG)) {
+		ret = env_export(&env_new);
+		if (!ret)
+			ret = env_sf_log_save(env_flash, CONFIG_ENV_OFFSET,
+					      ENV_LOG_SLOTS, &env_new);
+		goto done;
+	}
+
 	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
 		sect_size = env_flash->mtd.erasesize;
 
@@ -272,8 +402,12 @@ static int env_sf_load(void)
 	if (ret)
 		goto out;
 
-	ret = spi_flash_read(env_flash,
-		CONFIG_ENV_OFFSET, CONFIG_ENV_SIZE, buf);
+	if (IS_ENABLED(CONFIG_ENV_SPI_LOG))
+		ret = env_sf_log_load(env_flash, CONFIG_ENV_OFFSET,
+				      ENV_LOG_SLOTS, (env_t *)buf);
+	else
+		ret = spi_flash_read(env_flash,
+			CONFIG_ENV_OFFSET, CONFIG_ENV_SIZE, buf);
 	if (ret) {
 		env_set_default("spi_flash_read() failed", 0);
 		goto err_read;
@@ -302,6 +436,13 @@ static int env_sf_erase(void)
 	if (ret)
 		return ret;
 
+	/* Older copies in the log would show through, so erase them all */
+	if (IS_ENABLED(CONFIG_ENV_SPI_LOG)) {
+		ret = spi_flash_erase(env_flash, CONFIG_ENV_OFFSET,
+				      ENV_LOG_SIZE);
+		goto done;
+	}
+
 	memset(&env, 0, sizeof(env_t));
 	ret = spi_flash_write(env_flash, CONFIG_ENV_OFFSET, CONFIG_ENV_SIZE, &env);
 	if (ret)
@@ -325,6 +466,28 @@ __weak void *env_sf_get_env_addr(void)
 #endif
 }
 
+env_t *env_sf_log_find_mapped(void *log, int slots)
+{
+	const u8 *p;
+	env_t *env;
+	int slot, i;
+
+	for (slot = slots; slot > 0; slot--) {
+		p = (u8 *)log + (slot - 1) * CONFIG_ENV_SIZE;
+		for (i = 0; i < ENV_LOG_PROBE && p[i] == 0xff; i++)
+			;
+		if (i < ENV_LOG_PROBE)
+			break;
+	}
+	for (slot = max(slot, 1) - 1; slot > 0; slot--) {
+		env = (env_t *)((u8 *)log + slot * CONFIG_ENV_SIZE);
+		if (crc32(0, env->data, ENV_SIZE) == env->crc)
+			break;
+	}
+
+	return (env_t *)((u8 *)log + slot * CONFIG_ENV_SIZE);
+}
+
 /*
  * check if Environment on CONFIG_ENV_ADDR is valid.
  */
@@ -335,6 +498,9 @@ static int env_sf_init_addr(void)
 	if (!env_ptr)
 		return -ENOENT;
 
+	if (IS_ENABLED(CONFIG_ENV_SPI_LOG))
+		env_ptr = env_sf_log_find_mapped(env_ptr, ENV_LOG_SLOTS);
+
 	if (crc32(0, env_ptr->data, ENV_SIZE) == env_ptr->crc) {
 		gd->env_addr = (ulong)&(env_ptr->data);
 		gd->env_valid = ENV_VALID;
@@ -545,7 +545,7 @@ int fs_size(const char *filename, loff_t *size)
 static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 			     loff_t len, struct fstype_info *info)
 {
-	struct lmb lmb;
+	struct lmb lmb = {};
 	int ret;
 	loff_t size;
 	loff_t read_len;
@@ -567,7 +567,9 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
+	ret = lmb_alloc_addr(&lmb, addr, read_len) == addr ? 0 : -ENOSPC;
+	lmb_uninit(&lmb);
+	if (!ret)
 		return 0;
 
 	log_err("** Reading file would overwrite reserved memory **\n");
@@ -1217,6 +1217,8 @@ static int ubifs_parse_options(struct ubifs_info *c, char *options,
 				c->mount_opts.compr_type = UBIFS_COMPR_LZO;
 			else if (!strcmp(name, "zlib"))
 				c->mount_opts.compr_type = UBIFS_COMPR_ZLIB;
+			else if (!strcmp(name, "zstd"))
+				c->mount_opts.compr_type = UBIFS_COMPR_ZSTD;
 			else {
 				ubifs_err(c, "unknown compressor \"%s\"", name); //FIXME: is c ready?
 				kfree(name);
@@ -1351,6 +1353,9 @@ static int mount_ubifs(struct ubifs_info *c)
 		printf("UBIFS: only ro mode in U-Boot allowed.\n");
 		return -EACCES;
 	}
+
+	/* Files are only ever loaded whole, so always bulk-read data nodes */
+	c->bulk_read = 1;
 #endif
 
 	err = init_constants_early(c);
@@ -1757,6 +1762,7 @@ void ubifs_umount(struct ubifs_info *c)
 	kfree(c->bottom_up_buf);
 	ubifs_debugging_exit(c);
 #ifdef __UBOOT__
+	ubifs_zstd_free();
 	ubi_close_volume(c->ubi);
 	mutex_unlock(&c->umount_mutex);
 	/* Finally free U-Boot's global copy of superblock */
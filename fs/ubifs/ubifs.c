@@ -26,6 +26,7 @@
 #include <linux/compat.h>
 #include <linux/err.h>
 #include <linux/lzo.h>
+#include <linux/zstd.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -42,6 +43,52 @@ static int gzip_decompress(const unsigned char *in, size_t in_len,
 		      (unsigned long *)out_len, 0, 0);
 }
 
+#if IS_ENABLED(CONFIG_ZSTD)
+/* Decompression context, set up on first use and kept until unmount */
+static zstd_dctx *zstd_ctx;
+static void *zstd_workspace;
+
+void ubifs_zstd_free(void)
+{
+	free(zstd_workspace);
+	zstd_workspace = NULL;
+	zstd_ctx = NULL;
+}
+
+/*
+ * Unlike zstd_decompress(), which sets up a new context for every call,
+ * reuse one context for all data nodes since each holds at most one block.
+ */
+static int ubifs_zstd_decompress(const unsigned char *in, size_t in_len,
+				 unsigned char *out, size_t *out_len)
+{
+	size_t wsize, len;
+
+	if (!zstd_ctx) {
+		wsize = zstd_dctx_workspace_bound();
+		zstd_workspace = malloc(wsize);
+		if (!zstd_workspace)
+			return -ENOMEM;
+		zstd_ctx = zstd_init_dctx(zstd_workspace, wsize);
+		if (!zstd_ctx) {
+			ubifs_zstd_free();
+			return -EPERM;
+		}
+	}
+
+	len = zstd_decompress_dctx(zstd_ctx, out, *out_len, in, in_len);
+	if (zstd_is_error(len))
+		return -EINVAL;
+	*out_len = len;
+
+	return 0;
+}
+#else
+void ubifs_zstd_free(void)
+{
+}
+#endif
+
 /* Fake description object for the "none" compressor */
 static struct ubifs_compressor none_compr = {
 	.compr_type = UBIFS_COMPR_NONE,
@@ -71,6 +118,15 @@ static struct ubifs_compressor zlib_compr = {
 	.decompress = gzip_decompress,
 };
 
+static struct ubifs_compressor zstd_compr = {
+	.compr_type = UBIFS_COMPR_ZSTD,
+	.name = "zstd",
+#if IS_ENABLED(CONFIG_ZSTD)
+	.capi_name = "zstd",
+	.decompress = ubifs_zstd_decompress,
+#endif
+};
+
 /* All UBIFS compressors */
 struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
 
@@ -203,8 +259,11 @@ static int __init compr_init(struct ubifs_compressor *compr)
 
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 	ubifs_compressors[compr->compr_type]->name += gd->reloc_off;
-	ubifs_compressors[compr->compr_type]->capi_name += gd->reloc_off;
-	ubifs_compressors[compr->compr_type]->decompress += gd->reloc_off;
+	/* A NULL capi_name marks a compressor which is not compiled in */
+	if (compr->capi_name) {
+		ubifs_compressors[compr->compr_type]->capi_name += gd->reloc_off;
+		ubifs_compressors[compr->compr_type]->decompress += gd->reloc_off;
+	}
 #endif
 
 	if (compr->capi_name) {
@@ -238,6 +297,10 @@ int __init ubifs_compressors_init(void)
 	if (err)
 		return err;
 
+	err = compr_init(&zstd_compr);
+	if (err)
+		return err;
+
 	err = compr_init(&none_compr);
 	if (err)
 		return err;
@@ -672,23 +735,13 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+static int decompress_block(struct inode *inode, void *addr,
+			    unsigned int block, struct ubifs_data_node *dn)
 {
 	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -719,13 +772,76 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return decompress_block(inode, addr, block, dn);
+}
+
+/*
+ * Read up to @nblocks whole blocks starting at @block whose data nodes lie
+ * back to back in one LEB with a single flash read, decompressing them
+ * straight into @addr. Returns the number of blocks read, 0 if the caller
+ * has to fall back to read_block() or a negative error code.
+ */
+static int read_bulk(struct ubifs_info *c, struct inode *inode, void *addr,
+		     unsigned int block, unsigned int nblocks)
+{
+	struct bu_info *bu = &c->bu;
+	void *buf;
+	int err, i, n, nn = 0;
+
+	if (!c->bulk_read || nblocks < 2)
+		return 0;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err || bu->cnt < 2)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err == -EAGAIN ? 0 : err;
+
+	n = min_t(unsigned int, bu->blk_cnt, nblocks);
+	buf = bu->buf;
+	for (i = 0; i < n; i++, addr += UBIFS_BLOCK_SIZE) {
+		if (nn < bu->cnt &&
+		    key_block(c, &bu->zbranch[nn].key) == block + i) {
+			err = decompress_block(inode, addr, block + i, buf);
+			if (err)
+				return err;
+			buf += ALIGN(bu->zbranch[nn++].len, 8);
+		} else {
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		}
+	}
+
+	return n;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
-		       struct page *page, int last_block_size)
+		       struct page *page, int last_block_size,
+		       struct ubifs_data_node *dn)
 {
 	void *addr;
 	int err = 0, i;
 	unsigned int block, beyond;
-	struct ubifs_data_node *dn;
 	loff_t i_size = inode->i_size;
 
 	dbg_gen("ino %lu, pg %lu, i_size %lld",
@@ -741,10 +857,6 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		goto out;
 	}
 
-	dn = kmalloc(UBIFS_MAX_DATA_NODE_SZ, GFP_NOFS);
-	if (!dn)
-		return -ENOMEM;
-
 	i = 0;
 	while (1) {
 		int ret;
@@ -815,21 +927,15 @@ static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		if (err == -ENOENT) {
 			/* Not found, so it must be a hole */
 			dbg_gen("hole");
-			goto out_free;
+			goto out;
 		}
 		ubifs_err(c, "cannot read page %lu of inode %lu, error %d",
 			  page->index, inode->i_ino, err);
-		goto error;
+		return err;
 	}
 
-out_free:
-	kfree(dn);
 out:
 	return 0;
-
-error:
-	kfree(dn);
-	return err;
 }
 
 int ubifs_read(const char *filename, void *buf, loff_t offset,
@@ -839,8 +945,9 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	unsigned long inum;
 	struct inode *inode;
 	struct page page;
+	struct ubifs_data_node *dn;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 
@@ -887,23 +994,47 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 
 	count = (size + UBIFS_BLOCK_SIZE - 1) >> UBIFS_BLOCK_SHIFT;
 
+	dn = kmalloc(UBIFS_MAX_DATA_NODE_SZ, GFP_NOFS);
+	if (!dn) {
+		err = -ENOMEM;
+		goto put_inode;
+	}
+
 	page.addr = buf;
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
+	for (i = 0; i < count; i += n) {
 		/*
-		 * Make sure to not read beyond the requested size
+		 * All pages but the last are whole blocks inside the file, so
+		 * read as many of them at once as the flash layout allows
 		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
-
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
+		n = 0;
+		if (i + 1 < count)
+			n = read_bulk(c, inode, page.addr,
+				      page.index << UBIFS_BLOCKS_PER_PAGE_SHIFT,
+				      (count - 1 - i) << UBIFS_BLOCKS_PER_PAGE_SHIFT);
+		if (n < 0) {
+			err = n;
 			break;
+		}
+		n >>= UBIFS_BLOCKS_PER_PAGE_SHIFT;
+		if (!n) {
+			/*
+			 * Make sure to not read beyond the requested size
+			 */
+			if (((i + 1) == count) && (size < inode->i_size))
+				last_block_size = size - (i * PAGE_SIZE);
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+			err = do_readpage(c, inode, &page, last_block_size, dn);
+			if (err)
+				break;
+			n = 1;
+		}
+
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
 	}
+	kfree(dn);
 
 	if (err) {
 		printf("Error reading file '%s'\n", filename);
@@ -2398,6 +2398,9 @@ void ubifs_compress(const struct ubifs_info *c, const void *in_buf, int in_len,
 		    void *out_buf, int *out_len, int *compr_type);
 int ubifs_decompress(const struct ubifs_info *c, const void *buf, int len,
 		     void *out, int *out_len, int compr_type);
+#ifdef __UBOOT__
+void ubifs_zstd_free(void);
+#endif
 
 #include "debug.h"
 #include "misc.h"
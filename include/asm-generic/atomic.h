@@ -3,6 +3,8 @@
 #ifndef _ASM_GENERIC_ATOMIC_H
 #define _ASM_GENERIC_ATOMIC_H
 
+#include <linux/compiler.h>
+
 typedef struct { volatile int counter; } atomic_t;
 #if BITS_PER_LONG == 32
 typedef struct { volatile long long counter; } atomic64_t;
@@ -19,7 +21,7 @@ typedef struct { volatile long counter; } atomic64_t;
 
 static inline void atomic_add(int i, atomic_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter += i;
@@ -28,7 +30,7 @@ static inline void atomic_add(int i, atomic_t *v)
 
 static inline void atomic_sub(int i, atomic_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter -= i;
@@ -37,7 +39,7 @@ static inline void atomic_sub(int i, atomic_t *v)
 
 static inline void atomic_inc(atomic_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	++v->counter;
@@ -46,7 +48,7 @@ static inline void atomic_inc(atomic_t *v)
 
 static inline void atomic_dec(atomic_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	--v->counter;
@@ -55,7 +57,7 @@ static inline void atomic_dec(atomic_t *v)
 
 static inline int atomic_dec_and_test(volatile atomic_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 	int val;
 
 	local_irq_save(flags);
@@ -68,7 +70,7 @@ static inline int atomic_dec_and_test(volatile atomic_t *v)
 
 static inline int atomic_add_negative(int i, volatile atomic_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 	int val;
 
 	local_irq_save(flags);
@@ -81,7 +83,7 @@ static inline int atomic_add_negative(int i, volatile atomic_t *v)
 
 static inline void atomic_clear_mask(unsigned long mask, unsigned long *addr)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	*addr &= ~mask;
@@ -92,7 +94,7 @@ static inline void atomic_clear_mask(unsigned long mask, unsigned long *addr)
 
 static inline void atomic64_add(long long i, volatile atomic64_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter += i;
@@ -101,7 +103,7 @@ static inline void atomic64_add(long long i, volatile atomic64_t *v)
 
 static inline void atomic64_sub(long long i, volatile atomic64_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter -= i;
@@ -112,7 +114,7 @@ static inline void atomic64_sub(long long i, volatile atomic64_t *v)
 
 static inline void atomic64_add(long i, volatile atomic64_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter += i;
@@ -121,7 +123,7 @@ static inline void atomic64_add(long i, volatile atomic64_t *v)
 
 static inline void atomic64_sub(long i, volatile atomic64_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter -= i;
@@ -131,7 +133,7 @@ static inline void atomic64_sub(long i, volatile atomic64_t *v)
 
 static inline void atomic64_inc(volatile atomic64_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter += 1;
@@ -140,7 +142,7 @@ static inline void atomic64_inc(volatile atomic64_t *v)
 
 static inline void atomic64_dec(volatile atomic64_t *v)
 {
-	unsigned long flags = 0;
+	unsigned long __always_unused flags = 0;
 
 	local_irq_save(flags);
 	v->counter -= 1;
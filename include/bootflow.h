@@ -122,6 +122,8 @@ struct bootflow {
  * this uclass (used with things like "mmc")
  * @BOOTFLOWIF_SINGLE_MEDIA: (internal) Scan one media device in the uclass (used
  * with things like "mmc1")
+ * @BOOTFLOWIF_CACHED: (internal) The current bootflow was obtained from the
+ * bootflow cache, so the normal scan has not started yet
  */
 enum bootflow_iter_flags_t {
 	BOOTFLOWIF_FIXED		= 1 << 0,
@@ -137,6 +139,7 @@ enum bootflow_iter_flags_t {
 	BOOTFLOWIF_SKIP_GLOBAL		= 1 << 17,
 	BOOTFLOWIF_SINGLE_UCLASS	= 1 << 18,
 	BOOTFLOWIF_SINGLE_MEDIA		= 1 << 19,
+	BOOTFLOWIF_CACHED		= 1 << 20,
 };
 
 /**
@@ -206,6 +209,10 @@ enum bootflow_meth_flags_t {
  *	happens before the normal ones)
  * @method_flags: flags controlling which methods should be used for this @dev
  * (enum bootflow_meth_flags_t)
+ * @cache_dev: Bootdev of the bootflow obtained from the bootflow cache, NULL if
+ *	none. This bootflow is skipped if the normal scan finds it again
+ * @cache_part: Partition of the bootflow obtained from the bootflow cache
+ * @cache_method: Bootmeth of the bootflow obtained from the bootflow cache
  */
 struct bootflow_iter {
 	int flags;
@@ -227,6 +234,9 @@ struct bootflow_iter {
 	struct udevice **method_order;
 	bool doing_global;
 	int method_flags;
+	struct udevice *cache_dev;
+	int cache_part;
+	struct udevice *cache_method;
 };
 
 /**
@@ -275,6 +285,11 @@ int bootflow_iter_drop_bootmeth(struct bootflow_iter *iter,
  *
  * If @flags includes BOOTFLOWIF_ALL then bootflows with errors are returned too
  *
+ * With CONFIG_BOOTFLOW_CACHE, if @dev and @label are NULL and
+ * BOOTFLOWIF_ALL is not set, the bootflow recorded by the last boot is tried
+ * first. If it is still valid it is returned and the normal scan starts with
+ * the next call to bootflow_scan_next()
+ *
  * @dev:	Boot device to scan, NULL to work through all of them until it
  *	finds one that can supply a bootflow
  * @label:	Label to control the scan, NULL to work through all devices
@@ -349,6 +364,10 @@ int bootflow_boot(struct bootflow *bflow);
 /**
  * bootflow_run_boot() - Try to boot a bootflow
  *
+ * With CONFIG_BOOTFLOW_CACHE, a bootflow from a block device is recorded in the
+ * bootflow cache before it is booted. If booting fails it is dropped from the
+ * current environment, but not from storage
+ *
  * @iter: Current iteration (or NULL if none). Used to disable a bootmeth if the
  *	boot returns -ENOTSUPP
  * @bflow: Bootflow to boot
@@ -273,6 +273,8 @@ extern const efi_guid_t efi_guid_host_dev;
 #endif
 /* GUID of the EFI_BLOCK_IO_PROTOCOL */
 extern const efi_guid_t efi_block_io_guid;
+/* GUID of the EFI_BLOCK_IO2_PROTOCOL */
+extern const efi_guid_t efi_block_io2_guid;
 extern const efi_guid_t efi_global_variable_guid;
 extern const efi_guid_t efi_guid_console_control;
 extern const efi_guid_t efi_guid_device_path;
@@ -359,12 +361,16 @@ struct efi_open_protocol_info_item {
  * protocol GUID to the respective protocol interface
  *
  * @link:		link to the list of protocols of a handle
+ * @guid_link:		link to the list of handlers with the same GUID
+ * @handle:		handle on which the protocol is installed
  * @guid:		GUID of the protocol
  * @protocol_interface:	protocol interface
  * @open_infos:		link to the list of open protocol info items
  */
 struct efi_handler {
 	struct list_head link;
+	struct list_head guid_link;
+	efi_handle_t handle;
 	const efi_guid_t guid;
 	void *protocol_interface;
 	struct list_head open_infos;
@@ -409,6 +415,8 @@ enum efi_object_type {
 struct efi_object {
 	/* Every UEFI object is part of a global object list */
 	struct list_head link;
+	/* Entry in the hash table used to validate handles */
+	struct hlist_node hash_node;
 	/* The list of protocols */
 	struct list_head protocols;
 	enum efi_object_type type;
@@ -642,6 +650,8 @@ efi_status_t EFIAPI efi_unload_image(efi_handle_t image_handle);
 efi_status_t efi_search_protocol(const efi_handle_t handle,
 				 const efi_guid_t *protocol_guid,
 				 struct efi_handler **handler);
+/* Find the handlers of a protocol on all handles */
+struct list_head *efi_protocol_handlers(const efi_guid_t *protocol);
 /* Install new protocol on a handle */
 efi_status_t efi_add_protocol(const efi_handle_t handle,
 			      const efi_guid_t *protocol,
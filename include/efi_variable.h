@@ -93,6 +93,7 @@ efi_status_t efi_query_variable_info_int(u32 attributes,
 					 u64 *maximum_variable_size);
 
 #define EFI_VAR_FILE_NAME "ubootefi.var"
+#define EFI_VAR_BACKUP_NAME "ubootefi.bak"
 
 #define EFI_VAR_BUF_SIZE CONFIG_EFI_VAR_BUF_SIZE
 
@@ -145,6 +146,35 @@ struct efi_var_file {
  */
 efi_status_t efi_var_to_file(void);
 
+/**
+ * efi_var_file_schedule() - request saving non-volatile variables as file
+ *
+ * While saving is deferred by efi_var_file_defer() the file is written
+ * after CONFIG_EFI_VARIABLE_FILE_FLUSH_DELAY milliseconds or when the
+ * deferral ends, whatever comes first. Otherwise the file is written
+ * immediately.
+ *
+ * Return:	status code
+ */
+efi_status_t efi_var_file_schedule(void);
+
+/**
+ * efi_var_file_flush() - save non-volatile variables if a save is pending
+ *
+ * Return:	status code
+ */
+efi_status_t efi_var_file_flush(void);
+
+/**
+ * efi_var_file_defer() - defer saving non-volatile variables
+ *
+ * Changes are collected while a UEFI image is running. Ending the deferral
+ * writes pending changes.
+ *
+ * @defer:	true to start deferring, false to end it
+ */
+void efi_var_file_defer(bool defer);
+
 /**
  * efi_var_collect() - collect variables in buffer
  *
@@ -276,6 +276,22 @@ int env_reload(void);
  */
 int env_save(void);
 
+/**
+ * env_save_var() - Save a single variable to storage
+ *
+ * This changes @varname in the stored environment and then sets it in the
+ * current environment. Any other changes made since the environment was
+ * loaded are not saved. The stored environment is read back and patched
+ * without being imported, so this costs a read as well as a write but does
+ * not disturb the current environment.
+ *
+ * @varname: Variable to set
+ * @value: Value to set it to, or NULL to delete it
+ * Return: 0 if OK, -ENODEV if the environment cannot be saved, -ENOMSG if the
+ *	stored environment has a bad CRC, other -ve on error
+ */
+int env_save_var(const char *varname, const char *value);
+
 /**
  * env_erase() - Erase the environment on storage
  *
@@ -260,6 +260,63 @@ const char *env_fat_get_intf(void);
  * Return: string of device and partition
  */
 char *env_fat_get_dev_part(void);
+
+/**
+ * env_redirect() - Make the drivers load and save a copy of the environment
+ *
+ * While @env is set, env_import() copies what a driver loads into @env,
+ * env_export() hands @env to a driver to save and env_set_default() does
+ * nothing. The environment in use is not touched and no variable callbacks
+ * run.
+ *
+ * @env: Copy to use, or NULL to go back to the environment in use
+ */
+void env_redirect(env_t *env);
+
+/* struct spi_flash is defined as struct spi_nor by <spi_flash.h> */
+struct spi_nor;
+
+/**
+ * env_sf_log_save() - Add a copy of the environment to a log area in SPI flash
+ *
+ * With CONFIG_ENV_SPI_LOG, the area is a row of CONFIG_ENV_SIZE slots. The copy
+ * goes into the slot after the last one in use. The whole area is erased
+ * first if there is no such slot, or if it is not completely erased.
+ *
+ * @env_flash: SPI flash holding the area
+ * @offset: Offset of the area in the SPI flash
+ * @slots: Number of slots in the area
+ * @env_new: Environment to write
+ * Return: 0 if OK, -ve on error
+ */
+int env_sf_log_save(struct spi_nor *env_flash, u32 offset, int slots,
+		    env_t *env_new);
+
+/**
+ * env_sf_log_load() - Read the newest copy of the environment from a log area
+ *
+ * This reads the newest copy with a valid CRC. If there is none, @env holds an
+ * invalid copy, so that the caller's CRC check fails.
+ *
+ * @env_flash: SPI flash holding the area
+ * @offset: Offset of the area in the SPI flash
+ * @slots: Number of slots in the area
+ * @env: Returns the environment
+ * Return: 0 if OK, -ve on error
+ */
+int env_sf_log_load(struct spi_nor *env_flash, u32 offset, int slots,
+		    env_t *env);
+
+/**
+ * env_sf_log_find_mapped() - Find the newest copy in a memory-mapped log area
+ *
+ * This works like env_sf_log_load(), for use before relocation.
+ *
+ * @log: Address where the area is mapped
+ * @slots: Number of slots in the area
+ * Return: Newest copy with a valid CRC, or an invalid copy if there is none
+ */
+env_t *env_sf_log_find_mapped(void *log, int slots);
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENV_INTERNAL_H_ */
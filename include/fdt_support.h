@@ -82,6 +82,80 @@ void do_fixup_by_compat(void *fdt, const char *compat,
 			const char *prop, const void *val, int len, int create);
 void do_fixup_by_compat_u32(void *fdt, const char *compat,
 			    const char *prop, u32 val, int create);
+
+/**
+ * struct fdt_fixup_session - Property updates to apply to an FDT in one go
+ *
+ * Each fdt_setprop() moves the rest of the blob and changes the offset of
+ * every node after it, so a long run of fixups keeps moving the blob and
+ * looking nodes up again. A session instead records the updates, leaving the
+ * blob (and therefore all node offsets) untouched until fdt_fixup_commit(),
+ * which applies them working back from the last node so that no node has to
+ * be looked up again.
+ *
+ * @fdt: FDT being updated
+ * @edits: Pending updates, sorted by node offset
+ * @count: Number of pending updates
+ * @alloced: Number of entries allocated in @edits
+ */
+struct fdt_fixup_session {
+	void *fdt;
+	struct fdt_fixup_edit *edits;
+	int count;
+	int alloced;
+};
+
+/**
+ * fdt_fixup_begin() - Start a fixup session
+ *
+ * @sess: Session to set up
+ * @fdt: FDT to update
+ */
+void fdt_fixup_begin(struct fdt_fixup_session *sess, void *fdt);
+
+/**
+ * fdt_fixup_setprop() - Record a property update in a fixup session
+ *
+ * This behaves like fdt_setprop(), except that the FDT is not changed until
+ * fdt_fixup_commit() is called. Node offsets obtained from the FDT stay valid
+ * until then. A later update of the same property replaces an earlier one.
+ *
+ * @sess: Session to update
+ * @nodeoffset: Offset of node to update
+ * @name: Name of property to set
+ * @val: Value of the property (copied)
+ * @len: Length of @val in bytes
+ * @create: true to create the property if it does not exist, false to only
+ *	update an existing property
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if out of memory, other -FDT_ERR_...
+ *	value if @nodeoffset is not valid
+ */
+int fdt_fixup_setprop(struct fdt_fixup_session *sess, int nodeoffset,
+		      const char *name, const void *val, int len, bool create);
+
+/**
+ * fdt_fixup_commit() - Apply the updates in a fixup session and end it
+ *
+ * The updates are applied with fdt_setprop(), starting from the last node so
+ * that the offsets of the others stay valid.
+ *
+ * The FDT must have enough free space for the new properties, as with
+ * fdt_setprop(). An update which fails is reported with its node and property,
+ * and the remaining updates are still applied. The session is ended whether
+ * or not this succeeds.
+ *
+ * @sess: Session to commit
+ * Return: 0 if OK, else the -FDT_ERR_... value of the last failed update
+ */
+int fdt_fixup_commit(struct fdt_fixup_session *sess);
+
+/**
+ * fdt_fixup_abort() - End a fixup session without changing the FDT
+ *
+ * @sess: Session to drop
+ */
+void fdt_fixup_abort(struct fdt_fixup_session *sess);
+
 /**
  * Setup the memory node in the DT. Creates one if none was existing before.
  * Calls fdt_fixup_memory_banks() to populate a single reg pair covering the
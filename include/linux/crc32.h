@@ -6,9 +6,14 @@
 #define _LINUX_CRC32_H
 
 #include <linux/types.h>
+#include <u-boot/crc.h>
 /* #include <linux/bitrev.h> */
 
-extern u32  crc32_le(u32 crc, unsigned char const *p, size_t len);
+/*
+ * The Linux crc32_le() neither inverts the seed nor the result, which is
+ * what crc32_no_comp() in lib/crc32.c does.
+ */
+#define crc32_le(crc, p, len)	crc32_no_comp(crc, p, len)
 /* extern u32  crc32_be(u32 crc, unsigned char const *p, size_t len); */
 
 #define crc32(seed, data, length)  crc32_le(seed, (unsigned char const *)data, length)
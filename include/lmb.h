@@ -5,6 +5,7 @@
 
 #include <asm/types.h>
 #include <asm/u-boot.h>
+#include <linux/types.h>
 
 /*
  * Logical memory blocks.
@@ -41,33 +42,44 @@ struct lmb_property {
  *
  * case 1. CONFIG_LMB_USE_MAX_REGIONS is defined (legacy mode)
  *         => CONFIG_LMB_MAX_REGIONS is used to configure the region size,
- *         directly in the array lmb_region.region[], with the same
- *         configuration for memory and reserved regions.
+ *         with the same configuration for memory and reserved regions.
  *
  * case 2. CONFIG_LMB_USE_MAX_REGIONS is not defined, the size of each
  *         region is configurated *independently* with
  *         => CONFIG_LMB_MEMORY_REGIONS: struct lmb.memory_regions
  *         => CONFIG_LMB_RESERVED_REGIONS: struct lmb.reserved_regions
- *         lmb_region.region is only a pointer to the correct buffer,
- *         initialized in lmb_init(). This configuration is useful to manage
- *         more reserved memory regions with CONFIG_LMB_RESERVED_REGIONS.
+ *
+ * In both cases this only sets the number of regions held in struct lmb
+ * itself. lmb_region.region initially points to these arrays, initialized in
+ * lmb_init(). If more regions are needed, a larger array is allocated and the
+ * lmb must be released with lmb_uninit() when it is no longer needed.
+ * lmb_init() frees such an array itself, so a struct lmb must be zeroed before
+ * it is first initialised.
  */
+#if IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
+#define LMB_MEMORY_REGIONS	CONFIG_LMB_MAX_REGIONS
+#define LMB_RESERVED_REGIONS	CONFIG_LMB_MAX_REGIONS
+#else
+#define LMB_MEMORY_REGIONS	CONFIG_LMB_MEMORY_REGIONS
+#define LMB_RESERVED_REGIONS	CONFIG_LMB_RESERVED_REGIONS
+#endif
 
 /**
  * struct lmb_region - Description of a set of region.
  *
+ * The regions are sorted by base address and do not overlap, so they can be
+ * searched with a binary search.
+ *
  * @cnt: Number of regions.
  * @max: Size of the region array, max value of cnt.
  * @region: Array of the region properties
+ * @alloced: true if @region was allocated because more regions were needed
  */
 struct lmb_region {
 	unsigned long cnt;
 	unsigned long max;
-#if IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
-	struct lmb_property region[CONFIG_LMB_MAX_REGIONS];
-#else
 	struct lmb_property *region;
-#endif
+	bool alloced;
 };
 
 /**
@@ -86,13 +98,28 @@ struct lmb_region {
 struct lmb {
 	struct lmb_region memory;
 	struct lmb_region reserved;
-#if !IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
-	struct lmb_property memory_regions[CONFIG_LMB_MEMORY_REGIONS];
-	struct lmb_property reserved_regions[CONFIG_LMB_RESERVED_REGIONS];
-#endif
+	struct lmb_property memory_regions[LMB_MEMORY_REGIONS];
+	struct lmb_property reserved_regions[LMB_RESERVED_REGIONS];
 };
 
+/**
+ * lmb_init() - Initialise an lmb with no regions
+ *
+ * Any region arrays left allocated by earlier use of @lmb are freed, so the
+ * struct must be zeroed before it is initialised for the first time.
+ *
+ * @lmb:	the logical memory block struct
+ */
 void lmb_init(struct lmb *lmb);
+/**
+ * lmb_uninit() - Free memory allocated for an lmb
+ *
+ * This frees any region arrays which were allocated to hold more regions than
+ * fit in struct lmb. The lmb must be initialized again before it is reused.
+ *
+ * @lmb:	the logical memory block struct
+ */
+void lmb_uninit(struct lmb *lmb);
 void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd, void *fdt_blob);
 void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				phys_size_t size, void *fdt_blob);
@@ -115,6 +142,24 @@ phys_addr_t lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align,
 phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align,
 			     phys_addr_t max_addr);
 phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size);
+/**
+ * lmb_alloc_in_place - Reserve a region where it is, if it is suitable
+ *
+ * This is used to avoid copying something which has already been loaded to
+ * a suitable place. The region must lie in memory, must not overlap any
+ * reserved region and must meet the same constraints as lmb_alloc_base().
+ *
+ * @lmb:	the logical memory block struct
+ * @base:	base address of the region
+ * @size:	size of the region
+ * @align:	required alignment of @base
+ * @max_addr:	address which the region must end at or below, 0 for no
+ *		limit
+ * Return:	@base if the region was reserved, 0 if it is not suitable
+ */
+phys_addr_t lmb_alloc_in_place(struct lmb *lmb, phys_addr_t base,
+			       phys_size_t size, ulong align,
+			       phys_addr_t max_addr);
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr);
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr);
 /**
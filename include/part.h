@@ -550,6 +550,21 @@ int get_disk_guid(struct blk_desc *dev_desc, char *guid);
 
 #endif
 
+#if CONFIG_IS_ENABLED(EFI_PARTITION_CACHE)
+/**
+ * gpt_cache_invalidate() - Discard the GPT entries kept for a block device
+ *
+ * This must be called when the device is written or goes away, since the
+ * kept entries are then no longer known to match what is on the device.
+ *
+ * @uclass_id: Uclass ID of the device, or -1 for all devices
+ * @devnum: Device number, if @uclass_id is not -1
+ */
+void gpt_cache_invalidate(int uclass_id, int devnum);
+#else
+static inline void gpt_cache_invalidate(int uclass_id, int devnum) {}
+#endif
+
 #if CONFIG_IS_ENABLED(DOS_PARTITION)
 /**
  * is_valid_dos_buf() - Ensure that a DOS MBR image is valid
@@ -39,6 +39,39 @@ struct dm_spi_flash_ops {
 /* Access the serial operations for a device */
 #define sf_get_ops(dev) ((struct dm_spi_flash_ops *)(dev)->driver->ops)
 
+/**
+ * struct spi_flash_mmap - memory-mapped window onto a SPI flash
+ *
+ * This is filled in from dm_spi_get_mmap() on the flash device.
+ *
+ * @base:	memory address at which @offset is mapped
+ * @size:	size of the window, 0 if the flash is not memory-mapped
+ * @offset:	first flash offset which is visible in the window
+ */
+struct spi_flash_mmap {
+	ulong base;
+	uint size;
+	uint offset;
+};
+
+/**
+ * spi_flash_read_mmap() - Read from SPI flash, through its window if possible
+ *
+ * Data inside the memory-mapped window is copied directly from the window,
+ * avoiding the command overhead of the SPI controller. If @buf already is the
+ * mapped address of @offset, the data is used in place and nothing is copied.
+ * Anything else is read with spi_flash_read_dm().
+ *
+ * @dev:	SPI flash device
+ * @map:	Memory-mapped window of @dev
+ * @offset:	Offset into device in bytes to read from
+ * @len:	Number of bytes to read
+ * @buf:	Buffer to put the data that is read
+ * Return: 0 if OK, -ve on error
+ */
+int spi_flash_read_mmap(struct udevice *dev, const struct spi_flash_mmap *map,
+			u32 offset, size_t len, void *buf);
+
 #if CONFIG_IS_ENABLED(DM_SPI_FLASH)
 /**
  * spi_flash_read_dm() - Read data from SPI flash
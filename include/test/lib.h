@@ -11,4 +11,20 @@
 /* Declare a new library function test */
 #define LIB_TEST(_name, _flags)	UNIT_TEST(_name, _flags, lib_test)
 
+/**
+ * lib_test_fill() - fill a buffer with reproducible pseudo-random bytes
+ *
+ * @buf:	buffer to fill
+ * @len:	number of bytes to fill
+ */
+static inline void lib_test_fill(u8 *buf, size_t len)
+{
+	uint32_t seed = 0x12345678;
+
+	while (len--) {
+		seed = seed * 1103515245 + 12345;
+		*buf++ = seed >> 16;
+	}
+}
+
 #endif /* __TEST_LIB_H__ */
@@ -22,6 +22,22 @@ void sha512_starts(sha512_context * ctx);
 void sha512_update(sha512_context *ctx, const uint8_t *input, uint32_t length);
 void sha512_finish(sha512_context * ctx, uint8_t digest[SHA512_SUM_LEN]);
 
+/**
+ * sha512_process() - Hash whole blocks into the state
+ *
+ * This is shared by SHA-384 and SHA-512. Architectures may provide a faster
+ * version of this. The portable one is always available as
+ * sha512_process_generic().
+ *
+ * @ctx: Context to update
+ * @data: Data to hash
+ * @blocks: Number of SHA512_BLOCK_SIZE blocks in @data
+ */
+void sha512_process(sha512_context *ctx, const unsigned char *data,
+		    unsigned int blocks);
+void sha512_process_generic(sha512_context *ctx, const unsigned char *data,
+			    unsigned int blocks);
+
 void sha512_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
@@ -11,6 +11,7 @@
 #include <dm/device.h>
 #include <dm/root.h>
 #include <efi_loader.h>
+#include <efi_variable.h>
 #include <irq_func.h>
 #include <log.h>
 #include <malloc.h>
@@ -31,6 +32,28 @@ static efi_uintn_t efi_tpl = TPL_APPLICATION;
 /* This list contains all the EFI objects our payload has access to */
 LIST_HEAD(efi_obj_list);
 
+/* Number of buckets of the handle and protocol hash tables, a power of 2 */
+#define EFI_HASH_SIZE	64
+
+/* Hash table of all objects in efi_obj_list, used to validate handles */
+static struct hlist_head efi_obj_hash[EFI_HASH_SIZE];
+
+/**
+ * struct efi_protocol_index - handlers of a protocol on all handles
+ *
+ * @node:	entry in efi_protocol_hash
+ * @guid:	GUID of the protocol
+ * @handlers:	list of struct efi_handler, in the order of installation
+ */
+struct efi_protocol_index {
+	struct hlist_node node;
+	efi_guid_t guid;
+	struct list_head handlers;
+};
+
+/* Hash table of struct efi_protocol_index */
+static struct hlist_head efi_protocol_hash[EFI_HASH_SIZE];
+
 /* List of all events */
 __efi_runtime_data LIST_HEAD(efi_events);
 
@@ -492,6 +515,71 @@ static efi_status_t EFIAPI efi_free_pool_ext(void *buffer)
 	return EFI_EXIT(r);
 }
 
+static struct hlist_head *efi_obj_bucket(const efi_handle_t handle)
+{
+	uintptr_t addr = (uintptr_t)handle;
+
+	return &efi_obj_hash[((addr >> 4) ^ (addr >> 10)) &
+			     (EFI_HASH_SIZE - 1)];
+}
+
+static struct hlist_head *efi_protocol_bucket(const efi_guid_t *guid)
+{
+	u32 hash = 0;
+	int i;
+
+	for (i = 0; i < sizeof(guid->b); i++)
+		hash = hash * 31 + guid->b[i];
+
+	return &efi_protocol_hash[hash & (EFI_HASH_SIZE - 1)];
+}
+
+/**
+ * efi_protocol_index() - find the index entry of a protocol
+ *
+ * @guid:	GUID of the protocol
+ * @create:	create the entry if it does not exist
+ * Return:	index entry or NULL
+ */
+static struct efi_protocol_index *efi_protocol_index(const efi_guid_t *guid,
+						     bool create)
+{
+	struct hlist_head *bucket = efi_protocol_bucket(guid);
+	struct efi_protocol_index *index;
+
+	hlist_for_each_entry(index, bucket, node) {
+		if (!guidcmp(&index->guid, guid))
+			return index;
+	}
+	if (!create)
+		return NULL;
+
+	index = calloc(1, sizeof(*index));
+	if (!index)
+		return NULL;
+	guidcpy(&index->guid, guid);
+	INIT_LIST_HEAD(&index->handlers);
+	hlist_add_head(&index->node, bucket);
+
+	return index;
+}
+
+/**
+ * efi_protocol_handlers() - find the handlers of a protocol on all handles
+ *
+ * @protocol:	GUID of the protocol
+ * Return:	list of struct efi_handler linked by guid_link, or NULL if the
+ *		protocol is not installed on any handle
+ */
+struct list_head *efi_protocol_handlers(const efi_guid_t *protocol)
+{
+	struct efi_protocol_index *index;
+
+	index = efi_protocol_index(protocol, false);
+
+	return index ? &index->handlers : NULL;
+}
+
 /**
  * efi_add_handle() - add a new handle to the object list
  *
@@ -506,6 +594,7 @@ void efi_add_handle(efi_handle_t handle)
 		return;
 	INIT_LIST_HEAD(&handle->protocols);
 	list_add_tail(&handle->link, &efi_obj_list);
+	hlist_add_head(&handle->hash_node, efi_obj_bucket(handle));
 }
 
 /**
@@ -561,6 +650,23 @@ efi_status_t efi_search_protocol(const efi_handle_t handle,
 	return EFI_NOT_FOUND;
 }
 
+/**
+ * efi_protocol_index_del() - remove a handler from the protocol index
+ *
+ * @handler:	handler to remove
+ */
+static void efi_protocol_index_del(struct efi_handler *handler)
+{
+	struct efi_protocol_index *index;
+
+	list_del(&handler->guid_link);
+	index = efi_protocol_index(&handler->guid, false);
+	if (index && list_empty(&index->handlers)) {
+		hlist_del(&index->node);
+		free(index);
+	}
+}
+
 /**
  * efi_remove_protocol() - delete protocol from a handle
  * @handle:             handle from which the protocol shall be deleted
@@ -582,6 +688,7 @@ efi_status_t efi_remove_protocol(const efi_handle_t handle,
 	if (handler->protocol_interface != protocol_interface)
 		return EFI_NOT_FOUND;
 	list_del(&handler->link);
+	efi_protocol_index_del(handler);
 	free(handler);
 	return EFI_SUCCESS;
 }
@@ -628,6 +735,7 @@ void efi_delete_handle(efi_handle_t handle)
 	}
 
 	list_del(&handle->link);
+	hlist_del(&handle->hash_node);
 	free(handle);
 }
 
@@ -1070,7 +1178,7 @@ struct efi_object *efi_search_obj(const efi_handle_t handle)
 	if (!handle)
 		return NULL;
 
-	list_for_each_entry(efiobj, &efi_obj_list, link) {
+	hlist_for_each_entry(efiobj, efi_obj_bucket(handle), hash_node) {
 		if (efiobj == handle)
 			return efiobj;
 	}
@@ -1128,6 +1236,7 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 	struct efi_handler *handler;
 	efi_status_t ret;
 	struct efi_register_notify_event *event;
+	struct efi_protocol_index *index;
 
 	efiobj = efi_search_obj(handle);
 	if (!efiobj)
@@ -1135,13 +1244,23 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 	ret = efi_search_protocol(handle, protocol, NULL);
 	if (ret != EFI_NOT_FOUND)
 		return EFI_INVALID_PARAMETER;
+	index = efi_protocol_index(protocol, true);
+	if (!index)
+		return EFI_OUT_OF_RESOURCES;
 	handler = calloc(1, sizeof(struct efi_handler));
-	if (!handler)
+	if (!handler) {
+		if (list_empty(&index->handlers)) {
+			hlist_del(&index->node);
+			free(index);
+		}
 		return EFI_OUT_OF_RESOURCES;
+	}
 	memcpy((void *)&handler->guid, protocol, sizeof(efi_guid_t));
+	handler->handle = efiobj;
 	handler->protocol_interface = protocol_interface;
 	INIT_LIST_HEAD(&handler->open_infos);
 	list_add_tail(&handler->link, &efiobj->protocols);
+	list_add_tail(&handler->guid_link, &index->handlers);
 
 	/* Notify registered events */
 	list_for_each_entry(event, &efi_register_notify_events, link) {
@@ -1151,6 +1270,7 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 			notif = calloc(1, sizeof(*notif));
 			if (!notif) {
 				list_del(&handler->link);
+				efi_protocol_index_del(handler);
 				free(handler);
 				return EFI_OUT_OF_RESOURCES;
 			}
@@ -1397,10 +1517,8 @@ static efi_status_t EFIAPI efi_uninstall_protocol_interface
 		goto out;
 
 	/* If the last protocol has been removed, delete the handle. */
-	if (list_empty(&handle->protocols)) {
-		list_del(&handle->link);
-		free(handle);
-	}
+	if (list_empty(&handle->protocols))
+		efi_delete_handle(handle);
 out:
 	return EFI_EXIT(ret);
 }
@@ -1521,6 +1639,8 @@ static efi_status_t efi_locate_handle(
 	efi_uintn_t size = 0;
 	struct efi_register_notify_event *event;
 	struct efi_protocol_notification *handle = NULL;
+	struct list_head *handlers = NULL;
+	struct efi_handler *handler;
 
 	/* Check parameters */
 	switch (search_type) {
@@ -1551,6 +1671,12 @@ static efi_status_t efi_locate_handle(
 					  link);
 		efiobj = handle->handle;
 		size += sizeof(void *);
+	} else if (search_type == BY_PROTOCOL) {
+		handlers = efi_protocol_handlers(protocol);
+		if (!handlers)
+			return EFI_NOT_FOUND;
+		list_for_each_entry(handler, handlers, guid_link)
+			size += sizeof(void *);
 	} else {
 		list_for_each_entry(efiobj, &efi_obj_list, link) {
 			if (!efi_search(search_type, protocol, efiobj))
@@ -1578,6 +1704,9 @@ static efi_status_t efi_locate_handle(
 	if (search_type == BY_REGISTER_NOTIFY) {
 		*buffer = efiobj;
 		list_del(&handle->link);
+	} else if (search_type == BY_PROTOCOL) {
+		list_for_each_entry(handler, handlers, guid_link)
+			*buffer++ = handler->handle;
 	} else {
 		list_for_each_entry(efiobj, &efi_obj_list, link) {
 			if (!efi_search(search_type, protocol, efiobj))
@@ -2566,6 +2695,7 @@ static efi_status_t EFIAPI efi_locate_protocol(const efi_guid_t *protocol,
 	struct efi_handler *handler;
 	efi_status_t ret;
 	struct efi_object *efiobj;
+	struct list_head *handlers;
 
 	EFI_ENTRY("%pUs, %p, %p", protocol, registration, protocol_interface);
 
@@ -2603,10 +2733,11 @@ static efi_status_t EFIAPI efi_locate_protocol(const efi_guid_t *protocol,
 		if (ret == EFI_SUCCESS)
 			goto found;
 	} else {
-		list_for_each_entry(efiobj, &efi_obj_list, link) {
-			ret = efi_search_protocol(efiobj, protocol, &handler);
-			if (ret == EFI_SUCCESS)
-				goto found;
+		handlers = efi_protocol_handlers(protocol);
+		if (handlers && !list_empty(handlers)) {
+			handler = list_first_entry(handlers, struct efi_handler,
+						   guid_link);
+			goto found;
 		}
 	}
 not_found:
@@ -2778,10 +2909,8 @@ efi_uninstall_multiple_protocol_interfaces_int(efi_handle_t handle,
 	}
 	if (ret == EFI_SUCCESS) {
 		/* If the last protocol has been removed, delete the handle. */
-		if (list_empty(&handle->protocols)) {
-			list_del(&handle->link);
-			free(handle);
-		}
+		if (list_empty(&handle->protocols))
+			efi_delete_handle(handle);
 		goto out;
 	}
 
@@ -3200,9 +3329,14 @@ efi_status_t EFIAPI efi_start_image(efi_handle_t image_handle,
 			  (unsigned long)((uintptr_t)exit_status &
 			  ~EFI_ERROR_MASK));
 		current_image = parent_image;
+		if (!parent_image)
+			efi_var_file_defer(false);
 		return EFI_EXIT(exit_status);
 	}
 
+	/* Collect variable changes until the outermost image returns */
+	if (!parent_image)
+		efi_var_file_defer(true);
 	current_image = image_handle;
 	image_obj->header.type = EFI_OBJECT_TYPE_STARTED_IMAGE;
 	EFI_PRINT("Jumping into 0x%p\n", image_obj->entry);
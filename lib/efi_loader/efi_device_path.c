@@ -155,25 +155,28 @@ static efi_handle_t find_handle(struct efi_device_path *dp,
 {
 	efi_handle_t handle, best_handle = NULL;
 	efi_uintn_t len, best_len = 0;
+	struct list_head *dp_handlers;
+	struct efi_handler *dp_handler;
 
 	len = efi_dp_instance_size(dp);
 
-	list_for_each_entry(handle, &efi_obj_list, link) {
+	dp_handlers = efi_protocol_handlers(&efi_guid_device_path);
+	if (!dp_handlers)
+		return NULL;
+
+	list_for_each_entry(dp_handler, dp_handlers, guid_link) {
 		struct efi_handler *handler;
 		struct efi_device_path *dp_current;
 		efi_uintn_t len_current;
 		efi_status_t ret;
 
+		handle = dp_handler->handle;
 		if (guid) {
 			ret = efi_search_protocol(handle, guid, &handler);
 			if (ret != EFI_SUCCESS)
 				continue;
 		}
-		ret = efi_search_protocol(handle, &efi_guid_device_path,
-					  &handler);
-		if (ret != EFI_SUCCESS)
-			continue;
-		dp_current = handler->protocol_interface;
+		dp_current = dp_handler->protocol_interface;
 		if (short_path) {
 			dp_current = efi_dp_shorten(dp_current);
 			if (!dp_current)
@@ -25,6 +25,7 @@ struct efi_system_partition efi_system_partition = {
 };
 
 const efi_guid_t efi_block_io_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+const efi_guid_t efi_block_io2_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 
 /**
@@ -32,6 +33,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
  *
  * @header:	EFI object header
  * @ops:	EFI disk I/O protocol interface
+ * @ops2:	EFI disk I/O 2 protocol interface
  * @dev_index:	device index of block device
  * @media:	block I/O media information
  * @dp:		device path to the block device
@@ -42,6 +44,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 struct efi_disk_obj {
 	struct efi_object header;
 	struct efi_block_io ops;
+	struct efi_block_io2 ops2;
 	int dev_index;
 	struct efi_block_io_media media;
 	struct efi_device_path *dp;
@@ -313,6 +316,156 @@ static const struct efi_block_io block_io_disk_template = {
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+/**
+ * efi_disk_complete() - complete an EFI_BLOCK_IO2_PROTOCOL request
+ *
+ * U-Boot's block devices transfer data synchronously, so every request has
+ * finished when it is completed here. For a non-blocking request the result
+ * of the transfer is reported through the token and its event is signaled;
+ * errors detected before the transfer are returned directly as required by
+ * the UEFI specification.
+ *
+ * @token:	token passed by the caller, may be NULL
+ * @ret:	status of the request
+ * Return:	status code to return to the caller
+ */
+static efi_status_t efi_disk_complete(struct efi_block_io2_token *token,
+				      efi_status_t ret)
+{
+	if (!token || !token->event)
+		return ret;
+	if (ret != EFI_SUCCESS && ret != EFI_DEVICE_ERROR)
+		return ret;
+
+	token->transaction_status = ret;
+	efi_signal_event(token->event);
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_disk_reset_ex() - reset block device
+ *
+ * This function implements the Reset service of the EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @extended_verification:	extended verification
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_reset_ex(struct efi_block_io2 *this,
+					     char extended_verification)
+{
+	EFI_ENTRY("%p, %x", this, extended_verification);
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_read_blocks_ex() - reads blocks from device
+ *
+ * This function implements the ReadBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be read from
+ * @lba:			starting logical block for reading
+ * @token:			token for a non-blocking request or NULL
+ * @buffer_size:		size of the read buffer
+ * @buffer:			pointer to the destination buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_read_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba, struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	efi_status_t ret;
+
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+	ret = EFI_CALL(efi_disk_read_blocks(&diskobj->ops, media_id, lba,
+					    buffer_size, buffer));
+
+	return EFI_EXIT(efi_disk_complete(token, ret));
+}
+
+/**
+ * efi_disk_write_blocks_ex() - writes blocks to device
+ *
+ * This function implements the WriteBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be written to
+ * @lba:			starting logical block for writing
+ * @token:			token for a non-blocking request or NULL
+ * @buffer_size:		size of the write buffer
+ * @buffer:			pointer to the source buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_write_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba, struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	efi_status_t ret;
+
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+	ret = EFI_CALL(efi_disk_write_blocks(&diskobj->ops, media_id, lba,
+					     buffer_size, buffer));
+
+	return EFI_EXIT(efi_disk_complete(token, ret));
+}
+
+/**
+ * efi_disk_flush_blocks_ex() - flushes modified data to the device
+ *
+ * This function implements the FlushBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * As we always write synchronously nothing is done here.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @token:			token for a non-blocking request or NULL
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_flush_blocks_ex(struct efi_block_io2 *this,
+			 struct efi_block_io2_token *token)
+{
+	EFI_ENTRY("%p, %p", this, token);
+	return EFI_EXIT(efi_disk_complete(token, EFI_SUCCESS));
+}
+
+static const struct efi_block_io2 block_io2_disk_template = {
+	.reset = &efi_disk_reset_ex,
+	.read_blocks_ex = &efi_disk_read_blocks_ex,
+	.write_blocks_ex = &efi_disk_write_blocks_ex,
+	.flush_blocks_ex = &efi_disk_flush_blocks_ex,
+};
+
 /**
  * efi_fs_from_path() - retrieve simple file system protocol
  *
@@ -470,6 +623,7 @@ static efi_status_t efi_disk_add_dev(
 					&handle,
 					&efi_guid_device_path, diskobj->dp,
 					&efi_block_io_guid, &diskobj->ops,
+					&efi_block_io2_guid, &diskobj->ops2,
 					/*
 					 * esp_guid must be last entry as it
 					 * can be NULL. Its interface is NULL.
@@ -498,6 +652,7 @@ static efi_status_t efi_disk_add_dev(
 		}
 	}
 	diskobj->ops = block_io_disk_template;
+	diskobj->ops2 = block_io2_disk_template;
 	diskobj->dev_index = dev_index;
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
@@ -513,6 +668,7 @@ static efi_status_t efi_disk_add_dev(
 	if (part)
 		diskobj->media.logical_partition = 1;
 	diskobj->ops.media = &diskobj->media;
+	diskobj->ops2.media = &diskobj->media;
 	if (disk)
 		*disk = diskobj;
 
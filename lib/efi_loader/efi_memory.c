@@ -16,7 +16,9 @@
 #include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
-#include <linux/list_sort.h>
+#include <linux/bitops.h>
+#include <linux/log2.h>
+#include <linux/rbtree_augmented.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -26,17 +28,24 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
+/**
+ * struct efi_mem_list - memory map item
+ *
+ * @node:	node in the efi_mem tree
+ * @max_free:	largest number of free pages in a single item of the subtree
+ *		rooted at this item, used to search for free memory
+ * @desc:	memory descriptor
+ */
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
+	u64 max_free;
 	struct efi_mem_desc desc;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
-static LIST_HEAD(efi_mem);
+/* This tree contains all memory map items, sorted by start address */
+static struct rb_root efi_mem = RB_ROOT;
+/* Number of items in efi_mem */
+static efi_uintn_t efi_mem_entries;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -45,11 +54,12 @@ void *efi_bounce_buffer;
 /**
  * struct efi_pool_allocation - memory block allocated from pool
  *
- * @num_pages:	number of pages allocated
+ * @num_pages:	number of pages allocated, 0 for a chunk of a pool arena
  * @checksum:	checksum
  * @data:	allocated pool memory
  *
- * U-Boot services each UEFI AllocatePool() request as a separate
+ * U-Boot services small UEFI AllocatePool() requests from chunks of a pool
+ * arena, see struct efi_pool_arena, and larger ones as a separate
  * (multiple) page allocation. We have to track the number of pages
  * to be able to free the correct amount later.
  *
@@ -65,6 +75,44 @@ struct efi_pool_allocation {
 	char data[] __aligned(ARCH_DMA_MINALIGN);
 };
 
+/* Smallest and largest chunk, including the allocation header */
+#define EFI_POOL_MIN_CHUNK	(2 * sizeof(struct efi_pool_allocation))
+#define EFI_POOL_MAX_CHUNK	SZ_1K
+#define EFI_POOL_MAX_CHUNKS	(EFI_PAGE_SIZE / EFI_POOL_MIN_CHUNK)
+#define EFI_POOL_CLASSES	(ilog2(EFI_POOL_MAX_CHUNK) - \
+				 ilog2(EFI_POOL_MIN_CHUNK) + 1)
+
+/**
+ * struct efi_pool_arena - page from which pool allocations are carved
+ *
+ * @node:		entry in efi_pool_partial[] while chunks are free
+ * @checksum:		checksum, see arena_checksum()
+ * @memory_type:	memory type of the page
+ * @chunk_size:		size of each chunk, a power of two
+ * @num_chunks:		number of chunks in the arena
+ * @used:		number of chunks in use
+ * @map:		bitmap of the chunks in use
+ *
+ * Each arena occupies one page of a single memory type and is split into
+ * chunks of one size class. This keeps small allocations, which are by far
+ * the most common, from using a whole page and a memory map entry each.
+ * The chunks follow this header, which is padded so that the data of every
+ * chunk is suitably aligned.
+ */
+struct efi_pool_arena {
+	struct hlist_node node;
+	u64 checksum;
+	u32 memory_type;
+	u16 chunk_size;
+	u16 num_chunks;
+	u16 used;
+	unsigned long map[BITS_TO_LONGS(EFI_POOL_MAX_CHUNKS)];
+} __aligned(ARCH_DMA_MINALIGN);
+
+/* Arenas with free chunks, by memory type and size class */
+static struct hlist_head efi_pool_partial[EFI_MAX_MEMORY_TYPE]
+					 [EFI_POOL_CLASSES];
+
 /**
  * checksum() - calculate checksum for memory allocated from pool
  *
@@ -82,30 +130,20 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 }
 
 /**
- * efi_mem_cmp() - comparator function for sorting memory map
- *
- * Sorts the memory list from highest address to lowest address
+ * arena_checksum() - calculate checksum for a pool arena
  *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
- *
- * @priv:	unused
- * @a:		first memory area
- * @b:		second memory area
- * Return:	1 if @a is before @b, -1 if @b is before @a, 0 if equal
+ * @arena:	arena header
+ * Return:	checksum, always non-zero
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static u64 arena_checksum(struct efi_pool_arena *arena)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	u64 addr = (uintptr_t)arena;
+	u64 ret = (addr >> 32) ^ (addr << 32) ^ arena->chunk_size ^
+		  arena->memory_type ^ ~EFI_ALLOC_POOL_MAGIC;
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+	if (!ret)
+		++ret;
+	return ret;
 }
 
 /**
@@ -119,137 +157,222 @@ static uint64_t desc_get_end(struct efi_mem_desc *desc)
 	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
 }
 
+static inline u64 efi_mem_free_pages(struct efi_mem_list *mem)
+{
+	return mem->desc.type == EFI_CONVENTIONAL_MEMORY ?
+	       mem->desc.num_pages : 0;
+}
+
+static inline u64 efi_mem_compute_max_free(struct efi_mem_list *mem)
+{
+	u64 max_free = efi_mem_free_pages(mem);
+	struct efi_mem_list *child;
+
+	if (mem->node.rb_left) {
+		child = rb_entry(mem->node.rb_left, struct efi_mem_list, node);
+		max_free = max(max_free, child->max_free);
+	}
+	if (mem->node.rb_right) {
+		child = rb_entry(mem->node.rb_right, struct efi_mem_list, node);
+		max_free = max(max_free, child->max_free);
+	}
+
+	return max_free;
+}
+
+RB_DECLARE_CALLBACKS(static, efi_mem_augment, struct efi_mem_list, node,
+		     u64, max_free, efi_mem_compute_max_free)
+
+static struct efi_mem_list *efi_mem_next(struct efi_mem_list *mem)
+{
+	struct rb_node *node = rb_next(&mem->node);
+
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
+
+static struct efi_mem_list *efi_mem_prev(struct efi_mem_list *mem)
+{
+	struct rb_node *node = rb_prev(&mem->node);
+
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
+
 /**
- * efi_mem_sort() - sort memory map
+ * efi_mem_find() - find memory map item
  *
- * Sort the memory map and then try to merge adjacent memory areas.
+ * @addr:	address to look up
+ * @next:	if no item contains @addr, return the first item above it
+ * Return:	item containing @addr, or the item following @addr if @next
+ *		is set, or NULL
  */
-static void efi_mem_sort(void)
-{
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
-
-			prevmem = lmem;
+static struct efi_mem_list *efi_mem_find(u64 addr, bool next)
+{
+	struct rb_node *node = efi_mem.rb_node;
+	struct efi_mem_list *above = NULL;
+
+	while (node) {
+		struct efi_mem_list *mem;
+
+		mem = rb_entry(node, struct efi_mem_list, node);
+		if (addr < mem->desc.physical_start) {
+			above = mem;
+			node = node->rb_left;
+		} else if (addr >= desc_get_end(&mem->desc)) {
+			node = node->rb_right;
+		} else {
+			return mem;
 		}
 	}
+
+	return next ? above : NULL;
+}
+
+/**
+ * efi_mem_insert() - insert a new item into the memory map
+ *
+ * The caller must make sure that the item does not overlap any other.
+ *
+ * @new:	item to insert
+ */
+static void efi_mem_insert(struct efi_mem_list *new)
+{
+	struct rb_node **link = &efi_mem.rb_node;
+	struct rb_node *parent = NULL;
+	u64 free_pages = efi_mem_free_pages(new);
+
+	while (*link) {
+		struct efi_mem_list *mem;
+
+		parent = *link;
+		mem = rb_entry(parent, struct efi_mem_list, node);
+		mem->max_free = max(mem->max_free, free_pages);
+		if (new->desc.physical_start < mem->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	new->max_free = free_pages;
+	rb_link_node(&new->node, parent, link);
+	rb_insert_augmented(&new->node, &efi_mem, &efi_mem_augment);
+	++efi_mem_entries;
+}
+
+static void efi_mem_remove(struct efi_mem_list *mem)
+{
+	rb_erase_augmented(&mem->node, &efi_mem, &efi_mem_augment);
+	--efi_mem_entries;
+	free(mem);
+}
+
+/**
+ * efi_mem_resize() - change the range of a memory map item
+ *
+ * The new range must not overlap any other item and the item must keep its
+ * position in the map.
+ *
+ * @mem:	memory map item
+ * @start:	new start address
+ * @end:	new end address
+ */
+static void efi_mem_resize(struct efi_mem_list *mem, u64 start, u64 end)
+{
+	mem->desc.physical_start = start;
+	mem->desc.virtual_start = start;
+	mem->desc.num_pages = (end - start) >> EFI_PAGE_SHIFT;
+	efi_mem_augment_propagate(&mem->node, NULL);
+}
+
+/**
+ * efi_mem_merge_next() - merge a memory map item with the following one
+ *
+ * @mem:	memory map item
+ * Return:	true if the following item was merged into @mem
+ */
+static bool efi_mem_merge_next(struct efi_mem_list *mem)
+{
+	struct efi_mem_list *next = efi_mem_next(mem);
+	u64 end;
+
+	if (!next || desc_get_end(&mem->desc) != next->desc.physical_start ||
+	    mem->desc.type != next->desc.type ||
+	    mem->desc.attribute != next->desc.attribute)
+		return false;
+
+	end = desc_get_end(&next->desc);
+	efi_mem_remove(next);
+	efi_mem_resize(mem, mem->desc.physical_start, end);
+
+	return true;
 }
 
 /**
  * efi_mem_carve_out() - unmap memory region
  *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return:		the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
+ * Removes the range [@start, @end) from all memory map items overlapping
+ * it, splitting an item which extends on both sides of the range.
+ *
+ * @start:	start address
+ * @end:	end address
+ * Return:	0 on success, -ENOMEM if an item could not be split
  */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
-{
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+static int efi_mem_carve_out(u64 start, u64 end)
+{
+	struct efi_mem_list *mem = efi_mem_find(start, true);
+
+	while (mem && mem->desc.physical_start < end) {
+		struct efi_mem_list *next = efi_mem_next(mem);
+		u64 map_start = mem->desc.physical_start;
+		u64 map_end = desc_get_end(&mem->desc);
+
+		if (map_start < start && map_end > end) {
+			/* [ mem | carve | newmap ] */
+			struct efi_mem_list *newmap;
+
+			newmap = calloc(1, sizeof(*newmap));
+			if (!newmap)
+				return -ENOMEM;
+			newmap->desc = mem->desc;
+			efi_mem_resize(mem, map_start, start);
+			newmap->desc.physical_start = end;
+			newmap->desc.virtual_start = end;
+			newmap->desc.num_pages = (map_end - end) >>
+						 EFI_PAGE_SHIFT;
+			efi_mem_insert(newmap);
+			break;
+		} else if (map_start < start) {
+			efi_mem_resize(mem, map_start, start);
+		} else if (map_end > end) {
+			efi_mem_resize(mem, end, map_end);
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			efi_mem_remove(mem);
 		}
-
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+		mem = next;
 	}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
-
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+	return 0;
+}
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+/**
+ * efi_mem_is_ram() - check that a range only consists of free RAM
+ *
+ * @start:	start address
+ * @end:	end address
+ * Return:	true if the whole range is EFI_CONVENTIONAL_MEMORY
+ */
+static bool efi_mem_is_ram(u64 start, u64 end)
+{
+	struct efi_mem_list *mem = efi_mem_find(start, false);
+
+	while (mem && mem->desc.type == EFI_CONVENTIONAL_MEMORY) {
+		if (desc_get_end(&mem->desc) >= end)
+			return true;
+		start = desc_get_end(&mem->desc);
+		mem = efi_mem_next(mem);
+		if (mem && mem->desc.physical_start != start)
+			return false;
+	}
 
-	return EFI_CARVE_LOOP_AGAIN;
+	return false;
 }
 
 /**
@@ -265,10 +388,8 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_list *newlist, *prev;
+	u64 end = start + (pages << EFI_PAGE_SHIFT);
 	struct efi_event *evt;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
@@ -281,7 +402,18 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		return EFI_SUCCESS;
 
 	++efi_memory_map_key;
+
+	if (overlap_only_ram && !efi_mem_is_ram(start, end)) {
+		/*
+		 * The payload wanted to have RAM overlaps, but we overlapped
+		 * with a non-RAM or an unallocated region. Error out.
+		 */
+		return EFI_NO_MAPPING;
+	}
+
 	newlist = calloc(1, sizeof(*newlist));
+	if (!newlist)
+		return EFI_OUT_OF_RESOURCES;
 	newlist->desc.type = memory_type;
 	newlist->desc.physical_start = start;
 	newlist->desc.virtual_start = start;
@@ -300,60 +432,18 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return EFI_NO_MAPPING;
+	/* Remove whatever was mapped there before and add our new map */
+	if (efi_mem_carve_out(start, end)) {
+		free(newlist);
+		return EFI_OUT_OF_RESOURCES;
 	}
+	efi_mem_insert(newlist);
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Merge with the neighbours where possible */
+	prev = efi_mem_prev(newlist);
+	if (prev && efi_mem_merge_next(prev))
+		newlist = prev;
+	efi_mem_merge_next(newlist);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -407,22 +497,53 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
-	struct efi_mem_list *item;
+	struct efi_mem_list *item = efi_mem_find(addr, false);
 
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
+	if (item && (must_be_allocated ^
+		     (item->desc.type == EFI_CONVENTIONAL_MEMORY)))
+		return EFI_SUCCESS;
 
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
-		}
+	return EFI_NOT_FOUND;
+}
+
+/**
+ * efi_find_free_node() - find free memory pages in a subtree of the map
+ *
+ * @node:	root of the subtree
+ * @len:	size of memory area needed
+ * @max_addr:	highest address to allocate, page aligned
+ * Return:	pointer to free memory area or 0
+ */
+static uint64_t efi_find_free_node(struct rb_node *node, uint64_t len,
+				   uint64_t max_addr)
+{
+	struct efi_mem_list *mem;
+	uint64_t curmax, ret;
+
+	if (!node)
+		return 0;
+
+	/* Skip subtrees without a large enough free item */
+	mem = rb_entry(node, struct efi_mem_list, node);
+	if (mem->max_free < (len >> EFI_PAGE_SHIFT))
+		return 0;
+
+	/* Items to the right start above this one and are preferred */
+	if (desc_get_end(&mem->desc) + len <= max_addr) {
+		ret = efi_find_free_node(node->rb_right, len, max_addr);
+		if (ret)
+			return ret;
 	}
 
-	return EFI_NOT_FOUND;
+	/* We only take memory from free RAM */
+	if (mem->desc.type == EFI_CONVENTIONAL_MEMORY) {
+		curmax = min(max_addr, desc_get_end(&mem->desc));
+		/* Return the highest address in this map within bounds */
+		if (curmax >= mem->desc.physical_start + len)
+			return curmax - len;
+	}
+
+	return efi_find_free_node(node->rb_left, len, max_addr);
 }
 
 /**
@@ -434,44 +555,13 @@ static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
  */
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
 	/*
 	 * Prealign input max address, so we simplify our matching
 	 * logic below and can just reuse it as return pointer.
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
-	}
-
-	return 0;
+	return efi_find_free_node(efi_mem.rb_node, len, max_addr);
 }
 
 /**
@@ -618,6 +708,94 @@ void *efi_alloc_aligned_pages(u64 len, int memory_type, size_t align)
 	return (void *)(uintptr_t)aligned_mem;
 }
 
+/**
+ * efi_pool_alloc_chunk() - allocate a chunk from a pool arena
+ *
+ * Takes a chunk from an arena of the given memory type and size class,
+ * allocating a new arena page if none has a free chunk.
+ *
+ * @pool_type:	memory type
+ * @size:	number of bytes including the allocation header
+ * Return:	allocation header of the chunk or NULL
+ */
+static struct efi_pool_allocation *
+efi_pool_alloc_chunk(enum efi_memory_type pool_type, efi_uintn_t size)
+{
+	efi_uintn_t chunk_size = max_t(efi_uintn_t, roundup_pow_of_two(size),
+				       EFI_POOL_MIN_CHUNK);
+	int class = ilog2(chunk_size) - ilog2(EFI_POOL_MIN_CHUNK);
+	struct hlist_head *partial = &efi_pool_partial[pool_type][class];
+	struct efi_pool_arena *arena;
+	u64 addr;
+	int i;
+
+	if (hlist_empty(partial)) {
+		if (efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, 1,
+				       &addr) != EFI_SUCCESS)
+			return NULL;
+		arena = (struct efi_pool_arena *)(uintptr_t)addr;
+		memset(arena, 0, sizeof(*arena));
+		arena->memory_type = pool_type;
+		arena->chunk_size = chunk_size;
+		arena->num_chunks = (EFI_PAGE_SIZE - sizeof(*arena)) /
+				    chunk_size;
+		arena->checksum = arena_checksum(arena);
+		hlist_add_head(&arena->node, partial);
+	}
+	arena = hlist_entry(partial->first, struct efi_pool_arena, node);
+
+	for (i = 0; i < arena->num_chunks; i++) {
+		if (!(arena->map[i / BITS_PER_LONG] & BIT(i % BITS_PER_LONG)))
+			break;
+	}
+	arena->map[i / BITS_PER_LONG] |= BIT(i % BITS_PER_LONG);
+	if (++arena->used == arena->num_chunks)
+		hlist_del_init(&arena->node);
+
+	return (void *)arena + sizeof(*arena) + i * arena->chunk_size;
+}
+
+/**
+ * efi_pool_free_chunk() - return a chunk to its pool arena
+ *
+ * The arena page is freed once its last chunk has been returned.
+ *
+ * @alloc:	allocation header of the chunk
+ * Return:	status code
+ */
+static efi_status_t efi_pool_free_chunk(struct efi_pool_allocation *alloc)
+{
+	struct efi_pool_arena *arena;
+	efi_uintn_t offset;
+	int class, i;
+
+	arena = (struct efi_pool_arena *)((uintptr_t)alloc & ~EFI_PAGE_MASK);
+	offset = (void *)alloc - (void *)arena;
+	if (arena->checksum != arena_checksum(arena) ||
+	    offset < sizeof(*arena) ||
+	    (offset - sizeof(*arena)) % arena->chunk_size) {
+		printf("%s: illegal free 0x%p\n", __func__, alloc->data);
+		return EFI_INVALID_PARAMETER;
+	}
+	/* Avoid double free */
+	alloc->checksum = 0;
+
+	i = (offset - sizeof(*arena)) / arena->chunk_size;
+	arena->map[i / BITS_PER_LONG] &= ~BIT(i % BITS_PER_LONG);
+	class = ilog2(arena->chunk_size) - ilog2(EFI_POOL_MIN_CHUNK);
+	if (arena->used-- == arena->num_chunks)
+		hlist_add_head(&arena->node,
+			       &efi_pool_partial[arena->memory_type][class]);
+
+	if (!arena->used) {
+		hlist_del_init(&arena->node);
+		arena->checksum = 0;
+		return efi_free_pages((uintptr_t)arena, 1);
+	}
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_allocate_pool - allocate memory from pool
  *
@@ -642,6 +820,19 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 		return EFI_SUCCESS;
 	}
 
+	if (pool_type < EFI_MAX_MEMORY_TYPE &&
+	    size <= EFI_POOL_MAX_CHUNK - sizeof(struct efi_pool_allocation)) {
+		alloc = efi_pool_alloc_chunk(pool_type, size +
+					     sizeof(struct efi_pool_allocation));
+		if (!alloc)
+			return EFI_OUT_OF_RESOURCES;
+		alloc->num_pages = 0;
+		alloc->checksum = checksum(alloc);
+		*buffer = alloc->data;
+
+		return EFI_SUCCESS;
+	}
+
 	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, num_pages,
 			       &addr);
 	if (r == EFI_SUCCESS) {
@@ -697,11 +888,15 @@ efi_status_t efi_free_pool(void *buffer)
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
 
 	/* Check that this memory was allocated by efi_allocate_pool() */
-	if (((uintptr_t)alloc & EFI_PAGE_MASK) ||
-	    alloc->checksum != checksum(alloc)) {
+	if (((uintptr_t)alloc & (ARCH_DMA_MINALIGN - 1)) ||
+	    alloc->checksum != checksum(alloc) ||
+	    (alloc->num_pages && ((uintptr_t)alloc & EFI_PAGE_MASK))) {
 		printf("%s: illegal free 0x%p\n", __func__, buffer);
 		return EFI_INVALID_PARAMETER;
 	}
+	if (!alloc->num_pages)
+		return efi_pool_free_chunk(alloc);
+
 	/* Avoid double free */
 	alloc->checksum = 0;
 
@@ -728,8 +923,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	struct rb_node *node;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -737,10 +931,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_entries * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -756,16 +947,9 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem;
-
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
-	}
+	/* Copy tree into array, in ascending order */
+	for (node = rb_first(&efi_mem); node; node = rb_next(node))
+		*memory_map++ = rb_entry(node, struct efi_mem_list, node)->desc;
 
 	if (map_key)
 		*map_key = efi_memory_map_key;
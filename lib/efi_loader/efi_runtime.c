@@ -11,6 +11,7 @@
 #include <dm.h>
 #include <elf.h>
 #include <efi_loader.h>
+#include <efi_variable.h>
 #include <log.h>
 #include <malloc.h>
 #include <rtc.h>
@@ -206,6 +207,9 @@ static void EFIAPI efi_reset_system_boottime(
 			break;
 		}
 	}
+	/* Write variable changes collected while the image was running */
+	efi_var_file_defer(false);
+
 	switch (reset_type) {
 	case EFI_RESET_COLD:
 	case EFI_RESET_WARM:
@@ -26,6 +26,13 @@
 
 static const efi_guid_t shim_lock_guid = SHIM_LOCK_GUID;
 
+/* Changes of non-volatile variables are collected while an image runs */
+static bool efi_var_file_deferred;
+/* Non-volatile variables have changed since the file was last written */
+static bool efi_var_file_dirty;
+/* Timer event used to write collected changes */
+static struct efi_event *efi_var_file_timer;
+
 /**
  * efi_set_blk_dev_to_system_partition() - select EFI system partition
  *
@@ -117,11 +124,42 @@ efi_status_t __maybe_unused efi_var_collect(struct efi_var_file **bufp, loff_t *
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_var_write_file() - write a buffer with variables to a file
+ *
+ * @name:	file name on the EFI system partition
+ * @buf:	buffer with variables
+ * @len:	length of the buffer
+ * Return:	status code
+ */
+static efi_status_t __maybe_unused efi_var_write_file(const char *name,
+						      struct efi_var_file *buf,
+						      loff_t len)
+{
+	efi_status_t ret;
+	loff_t actlen;
+	int r;
+
+	ret = efi_set_blk_dev_to_system_partition();
+	if (ret != EFI_SUCCESS)
+		return ret;
+
+	r = fs_write(name, map_to_sysmem(buf), 0, len, &actlen);
+	if (r || len != actlen)
+		return EFI_DEVICE_ERROR;
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_var_to_file() - save non-volatile variables as file
  *
  * File ubootefi.var is created on the EFI system partion.
  *
+ * With CONFIG_EFI_VARIABLE_FILE_BACKUP the variables are first written to
+ * ubootefi.bak. So there always is one complete file even if the update of
+ * ubootefi.var is interrupted.
+ *
  * Return:	status code
  */
 efi_status_t efi_var_to_file(void)
@@ -130,20 +168,19 @@ efi_status_t efi_var_to_file(void)
 	efi_status_t ret;
 	struct efi_var_file *buf;
 	loff_t len;
-	loff_t actlen;
-	int r;
 
-	ret = efi_var_collect(&buf, &len, EFI_VARIABLE_NON_VOLATILE);
-	if (ret != EFI_SUCCESS)
-		goto error;
+	efi_var_file_dirty = false;
 
-	ret = efi_set_blk_dev_to_system_partition();
+	ret = efi_var_collect(&buf, &len, EFI_VARIABLE_NON_VOLATILE);
 	if (ret != EFI_SUCCESS)
 		goto error;
 
-	r = fs_write(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, len, &actlen);
-	if (r || len != actlen)
-		ret = EFI_DEVICE_ERROR;
+	if (IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_BACKUP)) {
+		ret = efi_var_write_file(EFI_VAR_BACKUP_NAME, buf, len);
+		if (ret != EFI_SUCCESS)
+			goto error;
+	}
+	ret = efi_var_write_file(EFI_VAR_FILE_NAME, buf, len);
 
 error:
 	if (ret != EFI_SUCCESS)
@@ -155,6 +192,64 @@ error:
 #endif
 }
 
+efi_status_t efi_var_file_flush(void)
+{
+	if (!efi_var_file_dirty)
+		return EFI_SUCCESS;
+
+	return efi_var_to_file();
+}
+
+/**
+ * efi_var_file_notify() - notification function of the flush timer
+ *
+ * @event:	timer event
+ * @context:	not used
+ */
+static void EFIAPI __maybe_unused efi_var_file_notify(struct efi_event *event,
+						      void *context)
+{
+	EFI_ENTRY("%p, %p", event, context);
+
+	efi_var_file_flush();
+
+	EFI_EXIT(EFI_SUCCESS);
+}
+
+efi_status_t efi_var_file_schedule(void)
+{
+#ifdef CONFIG_EFI_VARIABLE_FILE_STORE
+	efi_status_t ret;
+
+	if (!efi_var_file_deferred || !CONFIG_EFI_VARIABLE_FILE_FLUSH_DELAY)
+		return efi_var_to_file();
+	if (efi_var_file_dirty)
+		return EFI_SUCCESS;
+
+	if (!efi_var_file_timer) {
+		ret = efi_create_event(EVT_TIMER | EVT_NOTIFY_SIGNAL,
+				       TPL_CALLBACK, efi_var_file_notify, NULL,
+				       NULL, &efi_var_file_timer);
+		if (ret != EFI_SUCCESS)
+			return efi_var_to_file();
+	}
+	/* The trigger time is given in units of 100 ns */
+	ret = efi_set_timer(efi_var_file_timer, EFI_TIMER_RELATIVE,
+			    CONFIG_EFI_VARIABLE_FILE_FLUSH_DELAY * 10000ULL);
+	if (ret != EFI_SUCCESS)
+		return efi_var_to_file();
+	efi_var_file_dirty = true;
+#endif
+	return EFI_SUCCESS;
+}
+
+void efi_var_file_defer(bool defer)
+{
+	efi_var_file_deferred = defer;
+	if (!defer)
+		efi_var_file_flush();
+}
+
 efi_status_t efi_var_restore(struct efi_var_file *buf, bool safe)
 {
 	struct efi_var_entry *var, *last_var;
@@ -198,6 +293,35 @@ efi_status_t efi_var_restore(struct efi_var_file *buf, bool safe)
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_var_read_file() - read and check a file with variables
+ *
+ * @name:	file name on the EFI system partition
+ * @buf:	buffer of size EFI_VAR_BUF_SIZE
+ * Return:	status code, EFI_NOT_FOUND if the file cannot be read
+ */
+static efi_status_t __maybe_unused efi_var_read_file(const char *name,
+						     struct efi_var_file *buf)
+{
+	efi_status_t ret;
+	loff_t len;
+	int r;
+
+	ret = efi_set_blk_dev_to_system_partition();
+	if (ret != EFI_SUCCESS)
+		return ret;
+	r = fs_read(name, map_to_sysmem(buf), 0, EFI_VAR_BUF_SIZE, &len);
+	if (r || len < sizeof(struct efi_var_file))
+		return EFI_NOT_FOUND;
+	if (buf->reserved || buf->magic != EFI_VAR_FILE_MAGIC ||
+	    buf->length != len ||
+	    buf->crc32 != crc32(0, (u8 *)buf->var,
+				buf->length - sizeof(struct efi_var_file)))
+		return EFI_VOLUME_CORRUPTED;
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_var_from_file() - read variables from file
  *
@@ -213,9 +337,7 @@ efi_status_t efi_var_from_file(void)
 {
 #ifdef CONFIG_EFI_VARIABLE_FILE_STORE
 	struct efi_var_file *buf;
-	loff_t len;
 	efi_status_t ret;
-	int r;
 
 	buf = calloc(1, EFI_VAR_BUF_SIZE);
 	if (!buf) {
@@ -223,16 +345,19 @@ efi_status_t efi_var_from_file(void)
 		return EFI_OUT_OF_RESOURCES;
 	}
 
-	ret = efi_set_blk_dev_to_system_partition();
-	if (ret != EFI_SUCCESS)
+	ret = efi_var_read_file(EFI_VAR_FILE_NAME, buf);
+	if (ret == EFI_DEVICE_ERROR)
 		goto error;
-	r = fs_read(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, EFI_VAR_BUF_SIZE,
-		    &len);
-	if (r || len < sizeof(struct efi_var_file)) {
+	if (ret != EFI_SUCCESS && IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_BACKUP) &&
+	    efi_var_read_file(EFI_VAR_BACKUP_NAME, buf) == EFI_SUCCESS) {
+		log_warning("Using backup of EFI variables\n");
+		ret = EFI_SUCCESS;
+	}
+	if (ret == EFI_NOT_FOUND) {
 		log_err("Failed to load EFI variables\n");
 		goto error;
 	}
-	if (buf->length != len || efi_var_restore(buf, false) != EFI_SUCCESS)
+	if (ret != EFI_SUCCESS || efi_var_restore(buf, false) != EFI_SUCCESS)
 		log_err("Invalid EFI variables file\n");
 error:
 	free(buf);
@@ -8,8 +8,15 @@
 #include <common.h>
 #include <efi_loader.h>
 #include <efi_variable.h>
+#include <linux/log2.h>
 #include <u-boot/crc.h>
 
+/*
+ * Slots in the variable index per byte of the variable buffer. A variable
+ * entry takes at least 40 bytes so the index is never more than 40% full.
+ */
+#define EFI_VAR_INDEX_RATIO	16
+
 /*
  * The variables efi_var_file and efi_var_entry must be static to avoid
  * referencing them via the global offset table (section .got). The GOT
@@ -17,7 +24,125 @@
  * relocation during SetVirtualAddressMap().
  */
 static struct efi_var_file __efi_runtime_data *efi_var_buf;
-static struct efi_var_entry __efi_runtime_data *efi_current_var;
+
+/*
+ * Open addressing hash index over the variables in efi_var_buf. Each slot
+ * holds the offset of a variable entry relative to efi_var_buf or 0 if the
+ * slot is empty. Storing offsets keeps the index valid after
+ * SetVirtualAddressMap().
+ */
+static u32 __efi_runtime_data *efi_var_index;
+static u32 __efi_runtime_data efi_var_index_mask;
+
+/**
+ * efi_var_hash() - hash GUID and name of a variable
+ *
+ * @guid:	vendor GUID
+ * @name:	variable name
+ * Return:	hash value
+ */
+static u32 __efi_runtime efi_var_hash(const efi_guid_t *guid, const u16 *name)
+{
+	const u8 *pos = (const u8 *)guid;
+	u32 hash = 2166136261U;
+	int i;
+
+	for (i = 0; i < sizeof(efi_guid_t); ++i)
+		hash = (hash ^ pos[i]) * 16777619U;
+	for (; *name; ++name)
+		hash = (hash ^ *name) * 16777619U;
+
+	return hash;
+}
+
+/**
+ * efi_var_mem_next() - get the variable following a variable
+ *
+ * @var:	variable
+ * Return:	next variable, NULL if @var is the last one
+ */
+static struct efi_var_entry __efi_runtime
+*efi_var_mem_next(struct efi_var_entry *var)
+{
+	struct efi_var_entry *next;
+	u16 *data;
+
+	for (data = var->name; *data; ++data)
+		;
+	++data;
+	next = (struct efi_var_entry *)ALIGN((uintptr_t)data + var->length, 8);
+	if ((uintptr_t)next >= (uintptr_t)efi_var_buf + efi_var_buf->length)
+		return NULL;
+
+	return next;
+}
+
+/**
+ * efi_var_index_add() - add a variable to the index
+ *
+ * @var:	variable in efi_var_buf
+ */
+static void __efi_runtime efi_var_index_add(struct efi_var_entry *var)
+{
+	u32 i = efi_var_hash(&var->guid, var->name) & efi_var_index_mask;
+
+	while (efi_var_index[i])
+		i = (i + 1) & efi_var_index_mask;
+	efi_var_index[i] = (uintptr_t)var - (uintptr_t)efi_var_buf;
+}
+
+/**
+ * efi_var_index_del() - remove a variable from the index
+ *
+ * The slot of the variable is freed by moving later entries of the same probe
+ * sequence back. The offsets of all variables behind @var are reduced by @size
+ * as efi_var_mem_del() moves these variables down.
+ *
+ * @var:	variable in efi_var_buf
+ * @size:	number of bytes occupied by @var
+ */
+static void __efi_runtime efi_var_index_del(struct efi_var_entry *var,
+					    u32 size)
+{
+	u32 offset = (uintptr_t)var - (uintptr_t)efi_var_buf;
+	u32 i, j, k;
+
+	for (i = efi_var_hash(&var->guid, var->name) & efi_var_index_mask;
+	     efi_var_index[i] != offset; i = (i + 1) & efi_var_index_mask)
+		;
+	for (j = (i + 1) & efi_var_index_mask; efi_var_index[j];
+	     j = (j + 1) & efi_var_index_mask) {
+		var = (struct efi_var_entry *)
+		      ((uintptr_t)efi_var_buf + efi_var_index[j]);
+		k = efi_var_hash(&var->guid, var->name) & efi_var_index_mask;
+		/* Entry j may only move if its home slot is not in (i, j] */
+		if (i < j ? (k > i && k <= j) : (k > i || k <= j))
+			continue;
+		efi_var_index[i] = efi_var_index[j];
+		i = j;
+	}
+	efi_var_index[i] = 0;
+
+	for (i = 0; i <= efi_var_index_mask; ++i) {
+		if (efi_var_index[i] > offset)
+			efi_var_index[i] -= size;
+	}
+}
+
+/**
+ * efi_var_index_build() - create the index for all variables in efi_var_buf
+ */
+static void efi_var_index_build(void)
+{
+	struct efi_var_entry *var;
+
+	memset(efi_var_index, 0, (efi_var_index_mask + 1) * sizeof(u32));
+	if ((uintptr_t)efi_var_buf->var >=
+	    (uintptr_t)efi_var_buf + efi_var_buf->length)
+		return;
+	for (var = efi_var_buf->var; var; var = efi_var_mem_next(var))
+		efi_var_index_add(var);
+}
 
 /**
  * efi_var_mem_compare() - compare GUID and name with a variable
@@ -25,12 +150,11 @@ static struct efi_var_entry __efi_runtime_data *efi_current_var;
  * @var:	variable to compare
  * @guid:	GUID to compare
  * @name:	variable name to compare
- * @next:	pointer to next variable
  * Return:	true if match
  */
 static bool __efi_runtime
 efi_var_mem_compare(struct efi_var_entry *var, const efi_guid_t *guid,
-		    const u16 *name, struct efi_var_entry **next)
+		    const u16 *name)
 {
 	int i;
 	u8 *guid1, *guid2;
@@ -50,15 +174,6 @@ efi_var_mem_compare(struct efi_var_entry *var, const efi_guid_t *guid,
 			++var_name;
 	}
 
-	++data;
-
-	if (next)
-		*next = (struct efi_var_entry *)
-			ALIGN((uintptr_t)data + var->length, 8);
-
-	if (match)
-		efi_current_var = var;
-
 	return match;
 }
 
@@ -67,6 +182,7 @@ struct efi_var_entry __efi_runtime
 		  struct efi_var_entry **next)
 {
 	struct efi_var_entry *var, *last;
+	u32 i;
 
 	last = (struct efi_var_entry *)
 	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
@@ -79,28 +195,15 @@ struct efi_var_entry __efi_runtime
 		}
 		return NULL;
 	}
-	if (efi_current_var &&
-	    efi_var_mem_compare(efi_current_var, guid, name, next)) {
-		if (next && *next >= last)
-			*next = NULL;
-		return efi_current_var;
-	}
 
-	var = efi_var_buf->var;
-	if (var < last) {
-		for (; var;) {
-			struct efi_var_entry *pos;
-			bool match;
-
-			match = efi_var_mem_compare(var, guid, name, &pos);
-			if (pos >= last)
-				pos = NULL;
-			if (match) {
-				if (next)
-					*next = pos;
-				return var;
-			}
-			var = pos;
+	for (i = efi_var_hash(guid, name) & efi_var_index_mask;
+	     efi_var_index[i]; i = (i + 1) & efi_var_index_mask) {
+		var = (struct efi_var_entry *)
+		      ((uintptr_t)efi_var_buf + efi_var_index[i]);
+		if (efi_var_mem_compare(var, guid, name)) {
+			if (next)
+				*next = efi_var_mem_next(var);
+			return var;
 		}
 	}
 	if (next)
@@ -118,14 +221,13 @@ void __efi_runtime efi_var_mem_del(struct efi_var_entry *var)
 
 	last = (struct efi_var_entry *)
 	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
-	if (var <= efi_current_var)
-		efi_current_var = NULL;
 
 	for (data = var->name; *data; ++data)
 		;
 	++data;
 	next = (struct efi_var_entry *)
 	       ALIGN((uintptr_t)data + var->length, 8);
+	efi_var_index_del(var, (uintptr_t)next - (uintptr_t)var);
 	efi_var_buf->length -= (uintptr_t)next - (uintptr_t)var;
 
 	/* efi_memcpy_runtime() can be used because next >= var. */
@@ -164,6 +266,7 @@ efi_status_t __efi_runtime efi_var_mem_ins(
 			   sizeof(u16) * var_name_len);
 	efi_memcpy_runtime(data, data1, size1);
 	efi_memcpy_runtime((u8 *)data + size1, data2, size2);
+	efi_var_index_add(var);
 
 	var = (struct efi_var_entry *)
 	      ALIGN((uintptr_t)data + var->length, 8);
@@ -238,7 +341,7 @@ static void EFIAPI __efi_runtime
 efi_var_mem_notify_virtual_address_map(struct efi_event *event, void *context)
 {
 	efi_convert_pointer(0, (void **)&efi_var_buf);
-	efi_current_var = NULL;
+	efi_convert_pointer(0, (void **)&efi_var_index);
 }
 
 efi_status_t efi_var_mem_init(void)
@@ -246,6 +349,7 @@ efi_status_t efi_var_mem_init(void)
 	u64 memory;
 	efi_status_t ret;
 	struct efi_event *event;
+	efi_uintn_t slots;
 
 	ret = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES,
 				 EFI_RUNTIME_SERVICES_DATA,
@@ -260,6 +364,17 @@ efi_status_t efi_var_mem_init(void)
 			      (uintptr_t)efi_var_buf;
 	/* crc32 for 0 bytes = 0 */
 
+	slots = roundup_pow_of_two(EFI_VAR_BUF_SIZE / EFI_VAR_INDEX_RATIO);
+	ret = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+				 EFI_RUNTIME_SERVICES_DATA,
+				 efi_size_in_pages(slots * sizeof(u32)),
+				 &memory);
+	if (ret != EFI_SUCCESS)
+		return ret;
+	efi_var_index = (u32 *)(uintptr_t)memory;
+	efi_var_index_mask = slots - 1;
+	efi_var_index_build();
+
 	ret = efi_create_event(EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_CALLBACK,
 			       efi_var_mem_notify_exit_boot_services, NULL,
 			       NULL, &event);
@@ -350,4 +465,5 @@ efi_get_next_variable_name_mem(efi_uintn_t *variable_name_size,
 void efi_var_buf_update(struct efi_var_file *var_buf)
 {
 	memcpy(efi_var_buf, var_buf, EFI_VAR_BUF_SIZE);
+	efi_var_index_build();
 }
@@ -326,6 +326,18 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 		}
 	}
 
+	/* Nothing to do if the value does not change */
+	if (var && !delete && !append && var->attr == attributes &&
+	    var->length == data_size && var->time == time) {
+		u16 *old_data = var->name;
+
+		for (; *old_data; ++old_data)
+			;
+		++old_data;
+		if (!memcmp(old_data, data, data_size))
+			return EFI_SUCCESS;
+	}
+
 	if (delete) {
 		/* EFI_NOT_FOUND has been handled before */
 		attributes = var->attr;
@@ -353,12 +365,9 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 	else
 		ret = EFI_SUCCESS;
 
-	/*
-	 * Write non-volatile EFI variables to file
-	 * TODO: check if a value change has occured to avoid superfluous writes
-	 */
+	/* Write non-volatile EFI variables to file */
 	if (attributes & EFI_VARIABLE_NON_VOLATILE)
-		efi_var_to_file();
+		efi_var_file_schedule();
 
 	return EFI_SUCCESS;
 }
@@ -443,6 +452,9 @@ efi_set_variable_runtime(u16 *variable_name, const efi_guid_t *vendor,
  */
 void efi_variables_boot_exit_notify(void)
 {
+	/* Write changes collected while the image was running */
+	efi_var_file_defer(false);
+
 	/* Switch variable services functions to runtime version */
 	efi_runtime_services.get_variable = efi_get_variable_runtime;
 	efi_runtime_services.get_next_variable_name =
@@ -5,7 +5,7 @@
  * Copyright (c) 2018 Heinrich Schuchardt <xypron.glpk@gmx.de>
  *
  * This unit test checks the following boottime services:
- * AllocatePages, FreePages, GetMemoryMap
+ * AllocatePages, FreePages, GetMemoryMap, AllocatePool, FreePool
  *
  * The memory type used for the device tree is checked.
  */
@@ -13,6 +13,8 @@
 #include <efi_selftest.h>
 
 #define EFI_ST_NUM_PAGES 8
+#define EFI_ST_NUM_POOLS 64
+#define EFI_ST_POOL_SIZE 24
 
 static const efi_guid_t fdt_guid = EFI_FDT_GUID;
 static struct efi_boot_services *boottime;
@@ -93,6 +95,65 @@ static int find_in_memory_map(efi_uintn_t map_size,
 	return EFI_ST_SUCCESS;
 }
 
+/**
+ * test_pool() - check small pool allocations
+ *
+ * Many small pool allocations must not each consume a memory map entry.
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int test_pool(void)
+{
+	void *pools[EFI_ST_NUM_POOLS];
+	efi_uintn_t size_before = 0, size_after = 0;
+	efi_uintn_t map_key;
+	efi_uintn_t desc_size;
+	u32 desc_version;
+	efi_status_t ret;
+	int i;
+
+	boottime->get_memory_map(&size_before, NULL, &map_key, &desc_size,
+				 &desc_version);
+
+	for (i = 0; i < EFI_ST_NUM_POOLS; ++i) {
+		ret = boottime->allocate_pool(EFI_LOADER_DATA,
+					      EFI_ST_POOL_SIZE, &pools[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+		if ((uintptr_t)pools[i] & 7) {
+			efi_st_error("Pool memory not 8 byte aligned\n");
+			return EFI_ST_FAILURE;
+		}
+		boottime->set_mem(pools[i], EFI_ST_POOL_SIZE, i);
+	}
+
+	boottime->get_memory_map(&size_after, NULL, &map_key, &desc_size,
+				 &desc_version);
+	if (size_after > size_before + 2 * desc_size) {
+		efi_st_error("Pool allocations added %u memory map entries\n",
+			     (unsigned int)((size_after - size_before) /
+					    desc_size));
+		return EFI_ST_FAILURE;
+	}
+
+	for (i = 0; i < EFI_ST_NUM_POOLS; ++i) {
+		if (*(u8 *)pools[i] != i ||
+		    ((u8 *)pools[i])[EFI_ST_POOL_SIZE - 1] != i) {
+			efi_st_error("Pool allocations overlap\n");
+			return EFI_ST_FAILURE;
+		}
+		ret = boottime->free_pool(pools[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
 /*
  * execute() - execute unit test
  *
@@ -181,7 +242,8 @@ static int execute(void)
 			("Device tree not marked as ACPI reclaim memory\n");
 		return EFI_ST_FAILURE;
 	}
-	return EFI_ST_SUCCESS;
+
+	return test_pool();
 }
 
 EFI_UNIT_TEST(memory) = {
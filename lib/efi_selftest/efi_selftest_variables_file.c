@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_variables_file
+ *
+ * This test sets a non-volatile variable and then calls ResetSystem() or
+ * ExitBootServices() followed by ResetSystem(). While an image is running
+ * changes of non-volatile variables are only written to the variables
+ * file later. Whether they survived the reset is checked by reading the
+ * variable after restarting U-Boot (see test_efi_var_file.py).
+ */
+
+#include <efi_selftest.h>
+
+static struct efi_runtime_services *runtime;
+static const efi_guid_t guid_vendor =
+	EFI_GUID(0x8b6c8ec1, 0x9d12, 0x4d2d,
+		 0x8c, 0x70, 0x5e, 0x2a, 0xf1, 0x4d, 0x60, 0x3b);
+
+/**
+ * set_variable() - set a non-volatile variable
+ *
+ * @name:	variable name
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int set_variable(u16 *name)
+{
+	u8 data[] = "efi_st";
+	efi_status_t ret;
+
+	ret = runtime->set_variable(name, &guid_vendor,
+				    EFI_VARIABLE_NON_VOLATILE |
+				    EFI_VARIABLE_BOOTSERVICE_ACCESS |
+				    EFI_VARIABLE_RUNTIME_ACCESS,
+				    sizeof(data), data);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("SetVariable failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Setup unit test.
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	runtime = systable->runtime;
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Setup unit test, setting the variable before ExitBootServices().
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup_ebs(const efi_handle_t handle,
+		     const struct efi_system_table *systable)
+{
+	runtime = systable->runtime;
+	return set_variable(u"efi_st_var_ebs");
+}
+
+/*
+ * Execute unit test, setting the variable and resetting at boot time.
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute_reset(void)
+{
+	if (set_variable(u"efi_st_var_reset") != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	runtime->reset_system(EFI_RESET_COLD, EFI_SUCCESS, 0, NULL);
+	efi_st_error("Reset failed.\n");
+	return EFI_ST_FAILURE;
+}
+
+/*
+ * Execute unit test, the reset is done by the selftest framework.
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute_ebs(void)
+{
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(varfile_reset) = {
+	.name = "variables file reset",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute_reset,
+	.on_request = true,
+};
+
+EFI_UNIT_TEST(varfile_ebs) = {
+	.name = "variables file exit boot services",
+	.phase = EFI_SETUP_BEFORE_BOOTTIME_EXIT,
+	.setup = setup_ebs,
+	.execute = execute_ebs,
+	.on_request = true,
+};
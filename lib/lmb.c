@@ -74,48 +74,84 @@ static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
 	return 0;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
-
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	memmove(&rgn->region[r], &rgn->region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(struct lmb_property));
+	rgn->cnt--;
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+/**
+ * lmb_find_region() - Find the first region which ends at or above an address
+ *
+ * Since the regions are sorted and do not overlap, this is a binary search.
+ *
+ * @rgn: Set of regions to search
+ * @addr: Address to look for
+ * Return: index of the region, or rgn->cnt if all regions end below @addr
+ */
+static unsigned long lmb_find_region(struct lmb_region *rgn, phys_addr_t addr)
 {
-	unsigned long i;
+	unsigned long lo = 0, hi = rgn->cnt;
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-		rgn->region[i].flags = rgn->region[i + 1].flags;
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+		struct lmb_property *r = &rgn->region[mid];
+
+		if (r->base + r->size - 1 < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	rgn->cnt--;
+
+	return lo;
+}
+
+/**
+ * lmb_grow_region() - Make room for more regions
+ *
+ * The regions start off in the arrays inside struct lmb. When these are full
+ * the regions are moved to an allocated array, which is doubled in size each
+ * time it fills up.
+ *
+ * @rgn: Set of regions to grow
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+	struct lmb_property *region;
+	unsigned long max = rgn->max * 2;
+
+	region = malloc(max * sizeof(struct lmb_property));
+	if (!region)
+		return -ENOMEM;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(struct lmb_property));
+	if (rgn->alloced)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+	rgn->alloced = true;
+
+	return 0;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+void lmb_uninit(struct lmb *lmb)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	if (lmb->memory.alloced)
+		free(lmb->memory.region);
+	if (lmb->reserved.alloced)
+		free(lmb->reserved.region);
+	lmb->memory.alloced = false;
+	lmb->reserved.alloced = false;
 }
 
 void lmb_init(struct lmb *lmb)
 {
-#if IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
-	lmb->memory.max = CONFIG_LMB_MAX_REGIONS;
-	lmb->reserved.max = CONFIG_LMB_MAX_REGIONS;
-#else
-	lmb->memory.max = CONFIG_LMB_MEMORY_REGIONS;
-	lmb->reserved.max = CONFIG_LMB_RESERVED_REGIONS;
+	lmb_uninit(lmb);
+	lmb->memory.max = LMB_MEMORY_REGIONS;
+	lmb->reserved.max = LMB_RESERVED_REGIONS;
 	lmb->memory.region = lmb->memory_regions;
 	lmb->reserved.region = lmb->reserved_regions;
-#endif
 	lmb->memory.cnt = 0;
 	lmb->reserved.cnt = 0;
 }
@@ -231,85 +267,57 @@ void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 static long lmb_add_region_flags(struct lmb_region *rgn, phys_addr_t base,
 				 phys_size_t size, enum lmb_flags flags)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
-
-	if (rgn->cnt == 0) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-		rgn->cnt = 1;
-		return 0;
-	}
+	phys_addr_t end = base + size - 1;
+	struct lmb_property *prev = NULL, *next = NULL;
+	unsigned long i;
 
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		phys_size_t rgnflags = rgn->region[i].flags;
-		phys_addr_t end = base + size - 1;
-		phys_addr_t rgnend = rgnbase + rgnsize - 1;
-
-		if (rgnbase <= base && end <= rgnend) {
-			if (flags == rgnflags)
+	/* Find the place for the new region, just after any below it */
+	i = lmb_find_region(rgn, base);
+	if (i < rgn->cnt) {
+		next = &rgn->region[i];
+		if (next->base <= base && end <= next->base + next->size - 1) {
+			if (flags == next->flags)
 				/* Already have this region, so we're done */
 				return 0;
 			else
 				return -1; /* regions with new flags */
 		}
-
-		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
-		if (adjacent > 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (adjacent < 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
-			/* regions overlap */
-			return -1;
-		}
+		if (lmb_addrs_overlap(base, size, next->base, next->size))
+			return -1; /* regions overlap */
+		if (next->flags != flags ||
+		    lmb_addrs_adjacent(base, size, next->base, next->size) <= 0)
+			next = NULL;
+	}
+	if (i > 0) {
+		prev = &rgn->region[i - 1];
+		if (prev->flags != flags ||
+		    lmb_addrs_adjacent(base, size, prev->base, prev->size) >= 0)
+			prev = NULL;
 	}
 
-	if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
-		if (rgn->region[i].flags == rgn->region[i + 1].flags) {
-			lmb_coalesce_regions(rgn, i, i + 1);
-			coalesced++;
-		}
+	/* First try and coalesce this LMB with its neighbours */
+	if (prev && next) {
+		prev->size += size + next->size;
+		lmb_remove_region(rgn, i);
+		return 2;
+	} else if (prev) {
+		prev->size += size;
+		return 1;
+	} else if (next) {
+		next->base = base;
+		next->size += size;
+		return 1;
 	}
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= rgn->max)
+	if (rgn->cnt >= rgn->max && lmb_grow_region(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-			rgn->region[i + 1].flags = rgn->region[i].flags;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			rgn->region[i + 1].flags = flags;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-	}
-
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(struct lmb_property));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
+	rgn->region[i].flags = flags;
 	rgn->cnt++;
 
 	return 0;
@@ -334,21 +342,17 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size - 1;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_find_region(rgn, base);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (rgnbegin > base || end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -392,19 +396,18 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return lmb_reserve_flags(lmb, base, size, LMB_NONE);
 }
 
+/* Return the index of the lowest region overlapping (base, size), or -1 */
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
 	unsigned long i;
 
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	i = lmb_find_region(rgn, base);
+	if (i < rgn->cnt && lmb_addrs_overlap(base, size, rgn->region[i].base,
+					      rgn->region[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -497,25 +500,39 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return 0;
 }
 
+phys_addr_t lmb_alloc_in_place(struct lmb *lmb, phys_addr_t base,
+			       phys_size_t size, ulong align,
+			       phys_addr_t max_addr)
+{
+	if (base & (align - 1))
+		return 0;
+	if (max_addr != LMB_ALLOC_ANYWHERE && base + size > max_addr)
+		return 0;
+
+	/* lmb_reserve() accepts a region inside an existing reservation */
+	if (lmb_overlaps_region(&lmb->reserved, base, size) >= 0)
+		return 0;
+
+	return lmb_alloc_addr(lmb, base, size);
+}
+
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	unsigned long i;
 	long rgn;
 
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
+		i = lmb_find_region(&lmb->reserved, addr);
+		if (i < lmb->reserved.cnt) {
 			if (addr < lmb->reserved.region[i].base) {
 				/* first reserved range > requested address */
 				return lmb->reserved.region[i].base - addr;
 			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+			/* requested addr is in this reserved range */
+			return 0;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb->memory.region[lmb->memory.cnt - 1].base +
@@ -526,14 +543,12 @@ phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 
 int lmb_is_reserved_flags(struct lmb *lmb, phys_addr_t addr, int flags)
 {
-	int i;
+	long i;
+
+	i = lmb_overlaps_region(&lmb->reserved, addr, 1);
+	if (i >= 0)
+		return (lmb->reserved.region[i].flags & flags) == flags;
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return (lmb->reserved.region[i].flags & flags) == flags;
-	}
 	return 0;
 }
 
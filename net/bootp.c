@@ -20,6 +20,7 @@
 #include <linux/delay.h>
 #include <net/tftp.h>
 #include "bootp.h"
+#include "dhcp_race.h"
 #ifdef CONFIG_LED_STATUS
 #include <status_led.h>
 #endif
@@ -400,6 +401,12 @@ static void bootp_timeout_handler(void)
 	ulong time_taken = get_timer(bootp_start);
 
 	if (time_taken >= time_taken_max) {
+		if (dhcp_race_active()) {
+			/* Let the other racing clients carry on */
+			puts("\nRetry time exceeded\n");
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
 #ifdef CONFIG_BOOTP_MAY_FAIL
 		char *ethrotate;
 
@@ -712,7 +719,7 @@ void bootp_reset(void)
 	bootp_num_ids = 0;
 	bootp_try = 0;
 	bootp_start = get_timer(0);
-	bootp_timeout = 250;
+	bootp_timeout = CONFIG_BOOTP_INITIAL_TIMEOUT_MS;
 }
 
 void bootp_request(void)
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Concurrent DHCPv4 / DHCPv6 / link-local address acquisition
+ *
+ * Each client runs its own, unmodified state machine. Only one UDP and one
+ * timeout handler can be installed in net_loop() at a time, so while a race
+ * is in progress the handlers installed by a client are captured into a
+ * per-client slot and the race multiplexes received packets and timeouts
+ * to all clients which are still running. The first client to obtain an
+ * address gets the shared handlers back and carries on alone.
+ */
+
+#include <common.h>
+#include <log.h>
+#include <net.h>
+#include <net6.h>
+#include "bootp.h"
+#include "dhcp_race.h"
+#include "dhcpv6.h"
+#include "link_local.h"
+
+/* Granularity at which client timeouts are checked */
+#define DHCP_RACE_TICK_MS	10
+
+/**
+ * struct race_client - A client taking part in the race
+ *
+ * @name: Name shown to the user
+ * @start: Function which starts the client
+ * @ip6: true if the client acquires an IPv6 address
+ * @done: true if the client has given up
+ * @udp_handler: UDP handler installed by the client, NULL if none
+ * @time_handler: Timeout handler installed by the client, NULL if none
+ * @time_start: Time at which @time_handler was installed
+ * @time_delta: Timeout for @time_handler in milliseconds
+ */
+struct race_client {
+	const char *name;
+	void (*start)(void);
+	bool ip6;
+	bool done;
+	rxhand_f *udp_handler;
+	thand_f *time_handler;
+	ulong time_start;
+	ulong time_delta;
+};
+
+static void race_dhcp_start(void)
+{
+	bootp_reset();
+	net_ip.s_addr = 0;
+	dhcp_request();
+}
+
+static struct race_client race_clients[] = {
+	{ .name = "DHCP", .start = race_dhcp_start },
+#if defined(CONFIG_CMD_DHCP6)
+	{ .name = "DHCP6", .start = dhcp6_start, .ip6 = true },
+#endif
+#if defined(CONFIG_NET_DHCP_RACE_LINK_LOCAL)
+	{ .name = "link-local", .start = link_local_start },
+#endif
+};
+
+/* true while clients are racing */
+static bool racing;
+/* Client whose code is currently running, NULL if none */
+static struct race_client *race_cur;
+
+bool dhcp_race_active(void)
+{
+	return racing && race_cur;
+}
+
+static void race_finish(struct race_client *winner)
+{
+	ulong elapsed;
+
+	racing = false;
+	race_cur = NULL;
+	debug("%s: %s won\n", __func__, winner->name);
+
+	if (IS_ENABLED(CONFIG_IPV6))
+		use_ip6 = winner->ip6;
+
+	/* Hand the shared handlers over to the winner */
+	net_set_udp_handler(winner->udp_handler);
+	if (winner->time_handler) {
+		elapsed = get_timer(winner->time_start);
+		net_set_timeout_handler(elapsed < winner->time_delta ?
+					winner->time_delta - elapsed : 1,
+					winner->time_handler);
+	} else {
+		net_set_timeout_handler(0, NULL);
+	}
+}
+
+/* Check what happened after running some client code */
+static void race_check(struct race_client *client)
+{
+	struct race_client *c;
+
+	if (!racing)
+		return;
+
+	switch (net_state) {
+	case NETLOOP_SUCCESS:
+		/* e.g. link-local, which completes without autoload */
+		race_finish(client);
+		break;
+	case NETLOOP_RESTART:
+	case NETLOOP_FAIL:
+		client->done = true;
+		client->udp_handler = NULL;
+		client->time_handler = NULL;
+		printf("%s gave up\n", client->name);
+
+		for (c = race_clients; c < race_clients + ARRAY_SIZE(race_clients);
+		     c++) {
+			if (!c->done) {
+				/* Someone is still running, keep going */
+				net_set_state(NETLOOP_CONTINUE);
+				return;
+			}
+		}
+		/* Nobody left, let net_loop() deal with the failure */
+		racing = false;
+		break;
+	default:
+		break;
+	}
+}
+
+static void race_udp_handler(uchar *pkt, unsigned int dport,
+			     struct in_addr sip, unsigned int sport,
+			     unsigned int len)
+{
+	struct race_client *c;
+
+	for (c = race_clients;
+	     racing && c < race_clients + ARRAY_SIZE(race_clients); c++) {
+		if (c->done || !c->udp_handler)
+			continue;
+		race_cur = c;
+		c->udp_handler(pkt, dport, sip, sport, len);
+		race_cur = NULL;
+		race_check(c);
+	}
+}
+
+static void race_timeout_handler(void)
+{
+	struct race_client *c;
+	thand_f *f;
+
+	for (c = race_clients;
+	     racing && c < race_clients + ARRAY_SIZE(race_clients); c++) {
+		f = c->time_handler;
+		if (c->done || !f || get_timer(c->time_start) < c->time_delta)
+			continue;
+		c->time_handler = NULL;
+		race_cur = c;
+		f();
+		race_cur = NULL;
+		race_check(c);
+	}
+
+	if (racing)
+		net_set_timeout_handler(DHCP_RACE_TICK_MS,
+					race_timeout_handler);
+}
+
+bool dhcp_race_set_udp_handler(rxhand_f *f)
+{
+	if (!racing || !race_cur)
+		return false;
+	race_cur->udp_handler = f;
+
+	return true;
+}
+
+bool dhcp_race_set_timeout_handler(ulong iv, thand_f *f)
+{
+	if (!racing || !race_cur)
+		return false;
+	race_cur->time_handler = iv ? f : NULL;
+	race_cur->time_start = get_timer(0);
+	race_cur->time_delta = iv;
+
+	return true;
+}
+
+void dhcp_race_won(void)
+{
+	if (racing && race_cur)
+		race_finish(race_cur);
+}
+
+void dhcp_race_start(void)
+{
+	struct race_client *c;
+
+	for (c = race_clients; c < race_clients + ARRAY_SIZE(race_clients);
+	     c++) {
+		c->done = false;
+		c->udp_handler = NULL;
+		c->time_handler = NULL;
+	}
+	racing = true;
+
+	for (c = race_clients;
+	     racing && c < race_clients + ARRAY_SIZE(race_clients); c++) {
+		race_cur = c;
+		c->start();
+		race_cur = NULL;
+		race_check(c);
+	}
+
+	if (racing) {
+		net_set_udp_handler(race_udp_handler);
+		net_set_timeout_handler(DHCP_RACE_TICK_MS,
+					race_timeout_handler);
+	}
+}
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Concurrent DHCPv4 / DHCPv6 / link-local address acquisition
+ */
+
+#ifndef __DHCP_RACE_H__
+#define __DHCP_RACE_H__
+
+#include <net.h>
+
+#if defined(CONFIG_NET_DHCP_RACE)
+/**
+ * dhcp_race_start() - Start all address-acquisition clients at once
+ *
+ * Starts DHCPv4, DHCPv6 (if enabled) and link-local (if enabled) inside the
+ * current net_loop(). The first client to obtain an address wins; the others
+ * are dropped and the winner carries on as if it had been started on its own
+ * (e.g. with autoload).
+ */
+void dhcp_race_start(void);
+
+/**
+ * dhcp_race_active() - Check whether a racing client is running
+ *
+ * Return: true if the caller runs on behalf of a client which is still
+ *	racing for an address
+ */
+bool dhcp_race_active(void);
+
+/**
+ * dhcp_race_set_udp_handler() - Capture a client's UDP handler
+ *
+ * Called by net_set_udp_handler() so that each racing client keeps its own
+ * handler instead of replacing the shared one.
+ *
+ * @f: Handler being installed
+ * Return: true if the handler was captured, false if it must be installed
+ *	normally
+ */
+bool dhcp_race_set_udp_handler(rxhand_f *f);
+
+/**
+ * dhcp_race_set_timeout_handler() - Capture a client's timeout handler
+ *
+ * Called by net_set_timeout_handler(), see dhcp_race_set_udp_handler()
+ *
+ * @iv: Timeout in milliseconds, 0 to cancel
+ * @f: Handler being installed
+ * Return: true if the handler was captured, false if it must be installed
+ *	normally
+ */
+bool dhcp_race_set_timeout_handler(ulong iv, thand_f *f);
+
+/**
+ * dhcp_race_won() - Declare the running client the winner
+ *
+ * Called when a client has obtained its address (from net_auto_load()).
+ * Stops the race and hands the network loop over to the winning client.
+ */
+void dhcp_race_won(void);
+#else
+static inline bool dhcp_race_active(void)
+{
+	return false;
+}
+
+static inline bool dhcp_race_set_udp_handler(rxhand_f *f)
+{
+	return false;
+}
+
+static inline bool dhcp_race_set_timeout_handler(ulong iv, thand_f *f)
+{
+	return false;
+}
+
+static inline void dhcp_race_won(void)
+{
+}
+#endif
+
+#endif /* __DHCP_RACE_H__ */
@@ -18,8 +18,8 @@
 #define PORT_DHCP6_C	546	/* DHCP6 client UDP port */
 
 /* default timeout parameters (in ms) */
-#define SOL_MAX_DELAY_MS	1000
-#define SOL_TIMEOUT_MS		1000
+#define SOL_MAX_DELAY_MS	CONFIG_DHCP6_SOL_MAX_DELAY_MS
+#define SOL_TIMEOUT_MS		CONFIG_DHCP6_SOL_TIMEOUT_MS
 #define SOL_MAX_RT_MS		3600000
 #define REQ_TIMEOUT_MS		1000
 #define REQ_MAX_RT_MS		30000
@@ -622,8 +622,6 @@ static void dhcp6_state_machine(bool timeout, uchar *rx_pkt, unsigned int len)
 		sm_params.retry_cnt = 0;
 
 		if (sm_params.next_state == DHCP6_SOLICIT) {
-			/* delay a random ammount (special for SOLICIT) */
-			udelay((rand() % SOL_MAX_DELAY_MS) * 1000);
 			/* init timestamp variables after SOLICIT delay */
 			sm_params.dhcp6_start_ms = get_timer(0);
 			sm_params.dhcp6_retry_start_ms = sm_params.dhcp6_start_ms;
@@ -720,5 +718,15 @@ void dhcp6_start(void)
 	srand_mac();
 
 	sm_params.curr_state = DHCP6_INIT;
-	dhcp6_state_machine(false, NULL, 0);
+
+	/*
+	 * Delay a random amount before the first SOLICIT. Use a timeout rather
+	 * than waiting here, so that anything else running in the network loop
+	 * (e.g. a DHCPv4 client racing this one) carries on meanwhile.
+	 */
+	if (SOL_MAX_DELAY_MS)
+		net_set_timeout_handler(rand() % SOL_MAX_DELAY_MS + 1,
+					dhcp6_timeout_handler);
+	else
+		dhcp6_state_machine(false, NULL, 0);
 }
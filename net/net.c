@@ -123,6 +123,7 @@
 #if defined(CONFIG_CMD_WOL)
 #include "wol.h"
 #endif
+#include "dhcp_race.h"
 #include "dhcpv6.h"
 #include "net_rand.h"
 
@@ -307,6 +308,7 @@ U_BOOT_ENV_CALLBACK(dnsip, on_dnsip);
  */
 void net_auto_load(void)
 {
+	dhcp_race_won();
 #if defined(CONFIG_CMD_NFS) && !defined(CONFIG_SPL_BUILD)
 	const char *s = env_get("autoload");
 
@@ -527,6 +529,11 @@ restart:
 			net_ip.s_addr = 0;
 			dhcp_request();		/* Basically same as BOOTP */
 			break;
+#endif
+#if defined(CONFIG_NET_DHCP_RACE)
+		case DHCP_RACE:
+			dhcp_race_start();
+			break;
 #endif
 		case DHCP6:
 			if (IS_ENABLED(CONFIG_CMD_DHCP6))
@@ -842,6 +849,8 @@ rxhand_f *net_get_udp_handler(void)
 
 void net_set_udp_handler(rxhand_f *f)
 {
+	if (dhcp_race_set_udp_handler(f))
+		return;
 	debug_cond(DEBUG_INT_STATE, "--- net_loop UDP handler set (%p)\n", f);
 	if (f == NULL)
 		udp_packet_handler = dummy_handler;
@@ -872,6 +881,8 @@ void net_set_icmp_handler(rxhand_icmp_f *f)
 
 void net_set_timeout_handler(ulong iv, thand_f *f)
 {
+	if (dhcp_race_set_timeout_handler(iv, f))
+		return;
 	if (iv == 0) {
 		debug_cond(DEBUG_INT_STATE,
 			   "--- net_loop timeout handler cancelled\n");
@@ -1547,6 +1558,7 @@ common:
 	case BOOTP:
 	case CDP:
 	case DHCP:
+	case DHCP_RACE:
 	case LINKLOCAL:
 		if (memcmp(net_ethaddr, "\0\0\0\0\0\0", 6) == 0) {
 			int num = eth_get_dev_index();
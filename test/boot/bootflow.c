@@ -13,6 +13,7 @@
 #include <bootstd.h>
 #include <cli.h>
 #include <dm.h>
+#include <env.h>
 #include <expo.h>
 #ifdef CONFIG_SANDBOX
 #include <asm/test.h>
@@ -156,6 +157,65 @@ static int bootflow_cmd_glob(struct unit_test_state *uts)
 }
 BOOTSTD_TEST(bootflow_cmd_glob, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
 
+/* Check 'bootflow scan' trying the bootflow cache first */
+static int bootflow_cmd_cache(struct unit_test_state *uts)
+{
+	struct bootstd_priv *std;
+	struct bootflow *bflow;
+	char rec[80], stale[80];
+
+	if (!IS_ENABLED(CONFIG_BOOTFLOW_CACHE))
+		return -EAGAIN;
+	ut_assertok(bootstd_test_drop_bootdev_order(uts));
+
+	/* Record the extlinux bootflow as if it had been booted */
+	ut_assertok(run_command("bootflow scan -GH", 0));
+	ut_assertok(bootstd_get_priv(&std));
+	bflow = list_first_entry(&std->glob_head, struct bootflow, glob_node);
+	snprintf(rec, sizeof(rec), "mmc mmc1.bootdev 1 extlinux %x %s",
+		 bflow->size, bflow->fname);
+	snprintf(stale, sizeof(stale), "mmc mmc1.bootdev 1 extlinux %x %s",
+		 bflow->size + 1, bflow->fname);
+	ut_assertok(env_set("bootflow_cache", rec));
+
+	/* It should be found first and not again by the normal scan */
+	console_record_reset_enable();
+	ut_assertok(run_command("bootflow scan -lGH", 0));
+	ut_assert_nextline("Scanning for bootflows in all bootdevs");
+	ut_assert_nextline("Seq  Method       State   Uclass    Part  Name                      Filename");
+	ut_assert_nextlinen("---");
+	ut_assert_nextline("Trying cached bootflow in bootdev 'mmc1.bootdev':");
+	ut_assert_nextline("  0  extlinux     ready   mmc          1  mmc1.bootdev.part_1       /extlinux/extlinux.conf");
+	ut_assert_nextline("Scanning bootdev 'mmc2.bootdev':");
+	ut_assert_nextline("Scanning bootdev 'mmc1.bootdev':");
+	ut_assert_nextline("Scanning bootdev 'mmc0.bootdev':");
+	ut_assert_nextline("No more bootdevs");
+	ut_assert_nextlinen("---");
+	ut_assert_nextline("(1 bootflow, 1 valid)");
+	ut_assert_console_end();
+
+	/* A record which no longer matches is ignored */
+	ut_assertok(env_set("bootflow_cache", stale));
+	ut_assertok(run_command("bootflow scan -lGH", 0));
+	ut_assert_nextline("Scanning for bootflows in all bootdevs");
+	ut_assert_nextline("Seq  Method       State   Uclass    Part  Name                      Filename");
+	ut_assert_nextlinen("---");
+	ut_assert_nextline("Trying cached bootflow in bootdev 'mmc1.bootdev':");
+	ut_assert_nextline("Scanning bootdev 'mmc2.bootdev':");
+	ut_assert_nextline("Scanning bootdev 'mmc1.bootdev':");
+	ut_assert_nextline("  0  extlinux     ready   mmc          1  mmc1.bootdev.part_1       /extlinux/extlinux.conf");
+	ut_assert_nextline("Scanning bootdev 'mmc0.bootdev':");
+	ut_assert_nextline("No more bootdevs");
+	ut_assert_nextlinen("---");
+	ut_assert_nextline("(1 bootflow, 1 valid)");
+	ut_assert_console_end();
+
+	ut_assertok(env_set("bootflow_cache", NULL));
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_cmd_cache, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+
 /* Check 'bootflow scan -e' */
 static int bootflow_cmd_scan_e(struct unit_test_state *uts)
 {
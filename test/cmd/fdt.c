@@ -1364,6 +1364,112 @@ static int fdt_test_chosen(struct unit_test_state *uts)
 }
 FDT_TEST(fdt_test_chosen, UT_TESTF_CONSOLE_REC);
 
+/* Test the fixup session, which applies a batch of property updates */
+static int fdt_test_fixup_session(struct unit_test_state *uts)
+{
+	struct fdt_fixup_session sess;
+	int root, node, subnode, len, i;
+	char fdt[8192], name[16];
+	const char *val;
+
+	ut_assertok(make_fuller_fdt(uts, fdt, sizeof(fdt)));
+	fdt_shrink_to_minimum(fdt, 4096);	/* Resize with 4096 extra bytes */
+	ut_assertok(fdt_add_mem_rsv(fdt, 0x1234, 0x5678));
+
+	root = fdt_path_offset(fdt, "/");
+	node = fdt_path_offset(fdt, "/test-node@1234");
+	subnode = fdt_path_offset(fdt, "/test-node@1234/subnode");
+	ut_assert(node >= 0);
+	ut_assert(subnode >= 0);
+
+	/* Updates are recorded, in any order, without touching the FDT */
+	fdt_fixup_begin(&sess, fdt);
+	ut_assertok(fdt_fixup_setprop(&sess, subnode, "new-prop", "sub", 4,
+				      true));
+	ut_assertok(fdt_fixup_setprop(&sess, node, "compatible", "first", 6,
+				      false));
+	ut_assertok(fdt_fixup_setprop(&sess, node, "missing", "none", 5,
+				      false));
+	ut_assertok(fdt_fixup_setprop(&sess, root, "model", "Fixed up", 9,
+				      true));
+	ut_assertok(fdt_fixup_setprop(&sess, node, "compatible", "second", 7,
+				      false));
+	ut_asserteq(-FDT_ERR_BADOFFSET,
+		    fdt_fixup_setprop(&sess, node + 1, "bad", "", 0, true));
+	ut_asserteq_str("U-Boot FDT test", fdt_getprop(fdt, root, "model",
+						       NULL));
+	ut_assertnull(fdt_getprop(fdt, subnode, "new-prop", NULL));
+	ut_assertok(fdt_fixup_commit(&sess));
+
+	ut_assertok(fdt_check_header(fdt));
+	ut_asserteq(1, fdt_num_mem_rsv(fdt));
+	root = fdt_path_offset(fdt, "/");
+	node = fdt_path_offset(fdt, "/test-node@1234");
+	subnode = fdt_path_offset(fdt, "/test-node@1234/subnode");
+	ut_asserteq_str("Fixed up", fdt_getprop(fdt, root, "model", NULL));
+	ut_asserteq_str("second", fdt_getprop(fdt, node, "compatible", NULL));
+	ut_assertnull(fdt_getprop(fdt, node, "missing", NULL));
+	ut_asserteq_str("sub", fdt_getprop(fdt, subnode, "new-prop", NULL));
+	val = fdt_getprop(fdt, node, "clock-names", &len);
+	ut_asserteq(26, len);
+	ut_asserteq_mem("fixed\0i2c\0spi\0uart2\0uart1\0", val, len);
+	ut_asserteq_str("/test-node@1234",
+			fdt_getprop(fdt, fdt_path_offset(fdt, "/aliases"),
+				    "testnodealias", NULL));
+
+	/* An aborted session leaves the FDT alone */
+	fdt_fixup_begin(&sess, fdt);
+	ut_assertok(fdt_fixup_setprop(&sess, root, "model", "Dropped", 8,
+				      true));
+	fdt_fixup_abort(&sess);
+	ut_asserteq_str("Fixed up", fdt_getprop(fdt, root, "model", NULL));
+
+	/* A large batch keeps the offsets recorded at the start valid */
+	fdt_fixup_begin(&sess, fdt);
+	for (i = 0; i < 64; i++) {
+		snprintf(name, sizeof(name), "prop-%d", i);
+		ut_assertok(fdt_fixup_setprop(&sess, i & 1 ? subnode : node,
+					      name, &i, sizeof(i), true));
+	}
+	ut_assertok(fdt_fixup_setprop(&sess, node, "compatible", "third", 6,
+				      false));
+	ut_assertok(fdt_fixup_commit(&sess));
+
+	ut_assertok(fdt_check_header(fdt));
+	ut_asserteq(1, fdt_num_mem_rsv(fdt));
+	node = fdt_path_offset(fdt, "/test-node@1234");
+	subnode = fdt_path_offset(fdt, "/test-node@1234/subnode");
+	for (i = 0; i < 64; i++) {
+		snprintf(name, sizeof(name), "prop-%d", i);
+		val = fdt_getprop(fdt, i & 1 ? subnode : node, name, &len);
+		ut_asserteq(sizeof(i), len);
+		ut_asserteq_mem(&i, val, len);
+	}
+	ut_asserteq_str("third", fdt_getprop(fdt, node, "compatible", NULL));
+	ut_asserteq_str("sub", fdt_getprop(fdt, subnode, "new-prop", NULL));
+	ut_asserteq_str("Fixed up", fdt_getprop(fdt, root, "model", NULL));
+
+	/* A failed update is reported and the others are still applied */
+	fdt_fixup_begin(&sess, fdt);
+	ut_assertok(fdt_fixup_setprop(&sess, root, "model", "Last", 5, true));
+	ut_assertok(fdt_fixup_setprop(&sess, node, "huge", fdt, sizeof(fdt),
+				      true));
+	ut_assertok(fdt_fixup_setprop(&sess, subnode, "new-prop", "after", 6,
+				      true));
+	ut_assertok(console_record_reset_enable());
+	ut_asserteq(-FDT_ERR_NOSPACE, fdt_fixup_commit(&sess));
+	ut_assert_nextline("Unable to update property /test-node@1234:huge, err=FDT_ERR_NOSPACE");
+	ut_assertok(ut_check_console_end(uts));
+	node = fdt_path_offset(fdt, "/test-node@1234");
+	subnode = fdt_path_offset(fdt, "/test-node@1234/subnode");
+	ut_asserteq_str("Last", fdt_getprop(fdt, root, "model", NULL));
+	ut_assertnull(fdt_getprop(fdt, node, "huge", NULL));
+	ut_asserteq_str("after", fdt_getprop(fdt, subnode, "new-prop", NULL));
+
+	return 0;
+}
+FDT_TEST(fdt_test_fixup_session, UT_TESTF_CONSOLE_REC);
+
 static int fdt_test_apply(struct unit_test_state *uts)
 {
 	char fdt[8192], fdto[8192];
@@ -20,6 +20,7 @@ static int do_ut_cmd(struct cmd_tbl *cmdtp, int flag, int argc,
 		     char *const argv[])
 {
 	char long_str[CONFIG_SYS_CBSIZE + 42];
+	int i;
 
 	printf("%s: Testing commands\n", __func__);
 	run_command("env default -f -a", 0);
@@ -91,6 +92,53 @@ static int do_ut_cmd(struct cmd_tbl *cmdtp, int flag, int argc,
 		assert(!strcmp("2", env_get("adder")));
 	}
 
+	if (IS_ENABLED(CONFIG_HUSH_PARSE_CACHE)) {
+		static const char loop_cmd[] = "setenv list; "
+			"for n in a b c; do setenv list ${list}${n}${x}; done";
+
+		/* The cached parse must run the same way each time */
+		for (i = 0; i < 3; i++) {
+			run_commandf("setenv x %d", i);
+			assert(run_command(loop_cmd, 0) == 0);
+			snprintf(long_str, sizeof(long_str), "a%db%dc%d", i, i,
+				 i);
+			assert(!strcmp(long_str, env_get("list")));
+		}
+		assert(run_command("env delete -f list x n", 0) == 0);
+
+		/* A loop left by 'exit' is not kept, so stops again next time */
+		for (i = 0; i < 2; i++) {
+			run_command("setenv list; for n in a b c; do "
+				    "setenv list ${list}${n}; "
+				    "if test $n = b; then exit; fi; done; "
+				    "setenv list bad", 0);
+			assert(!strcmp("ab", env_get("list")));
+		}
+
+		/* Evicting the oldest strings keeps the others correct */
+		for (i = 0; i < 20; i++) {
+			snprintf(long_str, sizeof(long_str),
+				 "setenv list %d${x}", i);
+			run_commandf("setenv x %c", 'a' + i);
+			assert(run_command(long_str, 0) == 0);
+		}
+		run_command("setenv x z", 0);
+		assert(run_command("setenv list 0${x}", 0) == 0);
+		assert(!strcmp("0z", env_get("list")));
+		assert(run_command("setenv list 19${x}", 0) == 0);
+		assert(!strcmp("19z", env_get("list")));
+
+		/* A string which runs itself is parsed again for each level */
+		run_command("setenv self 'setenv depth ${depth}x; "
+			    "if test ${depth} != xxx; then run self; fi'", 0);
+		for (i = 0; i < 2; i++) {
+			run_command("setenv depth", 0);
+			run_command("run self", 0);
+			assert(!strcmp("xxx", env_get("depth")));
+		}
+		assert(run_command("env delete -f list x n self depth", 0) == 0);
+	}
+
 	/* Clean up before exit */
 	run_command("env default -f -a", 0);
 
@@ -21,6 +21,7 @@
 #include <test/test.h>
 #include <test/ut.h>
 #include <ndisc.h>
+#include "../../net/bootp.h"
 
 #define DM_TEST_ETH_NUM		4
 
@@ -609,6 +610,128 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 
 DM_TEST(dm_test_eth_async_ping_reply, UT_TESTF_SCAN_FDT);
 
+#if IS_ENABLED(CONFIG_NET_DHCP_RACE)
+/* Find the DHCP message type in a BOOTP packet sent by U-Boot */
+static int sb_dhcp_msg_type(struct bootp_hdr *bp)
+{
+	u8 *opt = (u8 *)bp->bp_vend + 4;
+
+	while (opt < (u8 *)bp->bp_vend + OPT_FIELD_SIZE && *opt != 0xff) {
+		if (*opt == 53)
+			return opt[2];
+		opt += *opt ? opt[1] + 2 : 1;
+	}
+
+	return -1;
+}
+
+/*
+ * Act as a DHCPv4 server, offering and acknowledging 1.1.2.5. Nothing answers
+ * DHCPv6, so DHCPv4 must win the race
+ */
+static int sb_dhcp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct in_addr server = string_to_ip("1.1.2.2");
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct bootp_hdr *bp = (void *)ip + IP_UDP_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+	struct bootp_hdr *bpr;
+	int type;
+	u8 *opt;
+
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP ||
+	    ntohs(ip->udp_dst) != 67)
+		return 0;
+
+	type = sb_dhcp_msg_type(bp);
+	if (type != DHCP_DISCOVER && type != DHCP_REQUEST)
+		return 0;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return 0;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	bpr = (void *)ipr + IP_UDP_HDR_SIZE;
+	memset(eth_recv, '\0', ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + sizeof(*bpr));
+
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	bpr->bp_op = OP_BOOTREPLY;
+	bpr->bp_htype = HWT_ETHER;
+	bpr->bp_hlen = HWL_ETHER;
+	bpr->bp_id = bp->bp_id;
+	memcpy(bpr->bp_chaddr, bp->bp_chaddr, HWL_ETHER);
+	net_write_ip(&bpr->bp_yiaddr, string_to_ip("1.1.2.5"));
+	net_write_ip(&bpr->bp_siaddr, server);
+
+	opt = (u8 *)bpr->bp_vend;
+	*opt++ = 99;	/* RFC1048 magic cookie */
+	*opt++ = 130;
+	*opt++ = 83;
+	*opt++ = 99;
+	*opt++ = 53;	/* DHCP message type */
+	*opt++ = 1;
+	*opt++ = type == DHCP_DISCOVER ? DHCP_OFFER : DHCP_ACK;
+	*opt++ = 54;	/* Server identifier */
+	*opt++ = 4;
+	net_write_ip(opt, server);
+	opt += 4;
+	*opt++ = 1;	/* Subnet mask */
+	*opt++ = 4;
+	net_write_ip(opt, string_to_ip("255.255.255.0"));
+	opt += 4;
+	*opt = 0xff;
+
+	net_set_ip_header((uchar *)ipr, string_to_ip("255.255.255.255"), server,
+			  IP_UDP_HDR_SIZE + sizeof(*bpr), IPPROTO_UDP);
+	ipr->udp_src = htons(67);
+	ipr->udp_dst = htons(68);
+	ipr->udp_len = htons(UDP_HDR_SIZE + sizeof(*bpr));
+	ipr->udp_xsum = 0;
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + sizeof(*bpr);
+	++priv->recv_packets;
+
+	return 0;
+}
+
+/* Only DHCPv4 is served, so it must win without waiting for DHCPv6 */
+static int dm_test_eth_dhcp_race(struct unit_test_state *uts)
+{
+	struct in_addr old_ip = net_ip;
+	ulong start;
+
+	sandbox_eth_set_tx_handler(0, sb_dhcp_handler);
+	env_set("ethact", "eth@10002000");
+	env_set("autoload", "no");
+	net_ip.s_addr = 0;
+
+	start = get_timer(0);
+	ut_assert(net_loop(DHCP_RACE) >= 0);
+	/* The DHCPv6 SOLICIT delay must not hold up DHCPv4 */
+	ut_assert(get_timer(start) < CONFIG_BOOTP_INITIAL_TIMEOUT_MS);
+	ut_asserteq(string_to_ip("1.1.2.5").s_addr, net_ip.s_addr);
+	ut_assert(!use_ip6);
+	ut_asserteq_str("eth@10002000", env_get("ethact"));
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	env_set("autoload", NULL);
+	net_ip = old_ip;
+
+	return 0;
+}
+DM_TEST(dm_test_eth_dhcp_race, UT_TESTF_SCAN_FDT);
+#endif
+
 #if IS_ENABLED(CONFIG_IPV6_ROUTER_DISCOVERY)
 
 static u8 ip6_ra_buf[] = {0x60, 0xf, 0xc5, 0x4a, 0x0, 0x38, 0x3a, 0xff, 0xfe,
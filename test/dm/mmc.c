@@ -4,9 +4,12 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
+#include <malloc.h>
 #include <mmc.h>
 #include <part.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -52,3 +55,135 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that multi-block reads use CMD23 only if the host can */
+static int dm_test_mmc_read_cmd23(struct unit_test_state *uts)
+{
+	struct sandbox_mmc_counts *counts;
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	char buf[16 * 512];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	counts = sandbox_mmc_get_counts(dev);
+
+	/* The SD card supports CMD23, so no CMD12 is needed */
+	memset(counts, '\0', sizeof(*counts));
+	ut_asserteq(16, blk_dread(dev_desc, 0, 16, buf));
+	ut_asserteq(1, counts->set_block_count);
+	ut_asserteq(0, counts->stop);
+
+	/* A host without the capability stops the transfer instead */
+	mmc_get_mmc_dev(dev)->host_caps &= ~MMC_CAP_CMD23;
+	ut_asserteq(16, blk_dread(dev_desc, 16, 16, buf));
+	ut_asserteq(1, counts->set_block_count);
+	ut_asserteq(1, counts->stop);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_read_cmd23, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that bulk eMMC writes use CMD23 and the volatile cache */
+static int dm_test_mmc_emmc_write(struct unit_test_state *uts)
+{
+	struct sandbox_mmc_counts *counts;
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	char *write, *read;
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(sandbox_mmc_set_emmc(dev, true));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	ut_asserteq(SZ_8M / 512, dev_desc->lba);
+	counts = sandbox_mmc_get_counts(dev);
+
+	write = malloc(256 * 512);
+	ut_assertnonnull(write);
+	read = malloc(256 * 512);
+	ut_assertnonnull(read);
+	for (i = 0; i < 256 * 512; i++)
+		write[i] = i;
+
+	/* This takes four transfers, so the cache is enabled around them */
+	ut_asserteq(256, blk_dwrite(dev_desc, 100, 256, write));
+	ut_asserteq(1, counts->cache_on);
+	ut_asserteq(1, counts->cache_off);
+	ut_asserteq(4, counts->set_block_count);
+	ut_asserteq(0, counts->stop);
+
+	/* A single transfer leaves the cache alone */
+	ut_asserteq(8, blk_dwrite(dev_desc, 0, 8, write));
+	ut_asserteq(1, counts->cache_on);
+	ut_asserteq(1, counts->cache_off);
+	ut_asserteq(5, counts->set_block_count);
+	ut_asserteq(0, counts->stop);
+
+	ut_asserteq(256, blk_dread(dev_desc, 100, 256, read));
+	ut_asserteq_mem(write, read, 256 * 512);
+
+	free(read);
+	free(write);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_emmc_write, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that eMMC erases cover as many erase groups as the host allows */
+static int dm_test_mmc_emmc_erase(struct unit_test_state *uts)
+{
+	const int grp = 1024, size = 3 * grp * 512;
+	struct sandbox_mmc_counts *counts;
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	char *buf, *expect;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(sandbox_mmc_set_emmc(dev, true));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	ut_asserteq(grp, mmc_get_mmc_dev(dev)->erase_grp_size);
+	ut_asserteq(300, mmc_get_mmc_dev(dev)->erase_timeout_ms);
+	counts = sandbox_mmc_get_counts(dev);
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	expect = malloc(size);
+	ut_assertnonnull(expect);
+	memset(expect, 0xa5, size);
+	ut_asserteq(3 * grp, blk_dwrite(dev_desc, 0, 3 * grp, expect));
+
+	/* Trim the unaligned head and tail, erase the whole group between */
+	memset(counts, '\0', sizeof(*counts));
+	ut_asserteq(2 * grp, blk_derase(dev_desc, grp / 2, 2 * grp));
+	ut_asserteq(3, counts->erase);
+	ut_asserteq(3, counts->erase_busy);
+	memset(expect + grp / 2 * 512, '\0', 2 * grp * 512);
+	ut_asserteq(3 * grp, blk_dread(dev_desc, 0, 3 * grp, buf));
+	ut_asserteq_mem(expect, buf, size);
+
+	/* Three 300ms groups fit in the 1s busy timeout of the host */
+	memset(counts, '\0', sizeof(*counts));
+	ut_asserteq(dev_desc->lba, blk_derase(dev_desc, 0, dev_desc->lba));
+	ut_asserteq(6, counts->erase);
+	ut_asserteq(6, counts->erase_busy);
+	memset(expect, '\0', size);
+	ut_asserteq(3 * grp, blk_dread(dev_desc, 0, 3 * grp, buf));
+	ut_asserteq_mem(expect, buf, size);
+
+	/*
+	 * If a single group takes longer than that, the whole device is erased
+	 * at once and the card is polled instead
+	 */
+	mmc_get_mmc_dev(dev)->erase_timeout_ms = 1200;
+	memset(counts, '\0', sizeof(*counts));
+	ut_asserteq(dev_desc->lba, blk_derase(dev_desc, 0, dev_desc->lba));
+	ut_asserteq(1, counts->erase);
+	ut_asserteq(0, counts->erase_busy);
+
+	free(expect);
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_emmc_erase, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
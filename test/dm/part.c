@@ -4,7 +4,10 @@
  */
 
 #include <common.h>
+#include <blk.h>
+#include <command.h>
 #include <dm.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <part.h>
 #include <part_efi.h>
@@ -94,6 +97,72 @@ static int dm_test_part(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_part, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/*
+ * Write a block behind the back of the block layer, as another OS or a
+ * failing device might, so that nothing is told about the change
+ */
+static int part_test_write_raw(struct blk_desc *desc, lbaint_t start,
+			       const void *buf)
+{
+	struct udevice *dev = desc->bdev;
+
+	return blk_get_ops(dev)->write(dev, start, 1, buf) == 1 ? 0 : -EIO;
+}
+
+/* Check that GPT entries are kept for lookups only, and dropped on writes */
+static int dm_test_part_gpt_cache(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER_PAD(gpt_header, head, 1, 512);
+	struct disk_partition info, parts[2] = {
+		{ .start = 48, .size = 1, .name = "test1", },
+		{ .start = 49, .size = 1, .name = "test2", },
+	};
+	char str_disk_guid[UUID_STR_LEN + 1];
+	struct blk_desc *desc;
+	lbaint_t pte_lba;
+
+	if (!CONFIG_IS_ENABLED(EFI_PARTITION_CACHE))
+		return -EAGAIN;
+
+	ut_asserteq(2, blk_get_device_by_str("mmc", "2", &desc));
+	ut_asserteq(512, desc->blksz);
+	if (CONFIG_IS_ENABLED(RANDOM_UUID)) {
+		gen_rand_uuid_str(parts[0].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(parts[1].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(str_disk_guid, UUID_STR_FORMAT_STD);
+	}
+	ut_assertok(gpt_restore(desc, str_disk_guid, parts, ARRAY_SIZE(parts)));
+	ut_asserteq(1, part_get_info_by_name(desc, "test1", &info));
+	ut_asserteq(2, part_get_info_by_name(desc, "test2", &info));
+
+	/* Renaming writes a new GPT, which a lookup must see */
+	ut_assertok(run_command("gpt rename mmc 2 1 first", 0));
+	ut_asserteq(1, part_get_info_by_name(desc, "first", &info));
+	ut_asserteq(-ENOENT, part_get_info_by_name(desc, "test1", &info));
+	ut_assertok(run_command("gpt verify mmc 2", 0));
+
+	/* Corrupt the primary entries and the backup header behind our back */
+	ut_asserteq(1, blk_dread(desc, GPT_PRIMARY_PARTITION_TABLE_LBA, 1,
+				 head));
+	pte_lba = le64_to_cpu(head->partition_entry_lba);
+	memset(head, '\0', desc->blksz);
+	ut_assertok(part_test_write_raw(desc, pte_lba, head));
+	ut_assertok(part_test_write_raw(desc, desc->lba - 1, head));
+
+	/* The header is unchanged, so a lookup still uses the kept entries */
+	ut_asserteq(1, part_get_info_by_name(desc, "first", &info));
+
+	/* but verifying always reads them */
+	ut_asserteq(1, run_command("gpt verify mmc 2", 0));
+
+	/* Once the device is written, the entries are read again */
+	ut_asserteq(1, blk_dwrite(desc, pte_lba, 1, head));
+	ut_asserteq(-ENOENT, part_get_info_by_name(desc, "first", &info));
+
+	return 0;
+}
+DM_TEST(dm_test_part_gpt_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 static int dm_test_part_bootable(struct unit_test_state *uts)
 {
 	struct blk_desc *desc;
@@ -7,6 +7,7 @@
 #include <command.h>
 #include <dm.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <os.h>
 #include <spi.h>
@@ -75,6 +76,65 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_spi_flash, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test reading SPI flash through its memory-mapped window */
+static int dm_test_spi_flash_mmap(struct unit_test_state *uts)
+{
+	struct spi_flash_mmap map;
+	int full_size = 0x200000;
+	struct udevice *dev;
+	u8 *win, *saved;
+	u8 buf[0x40];
+	int i;
+
+	ut_assertok(os_write_file("spi.bin", map_sysmem(0x20000, full_size),
+				  full_size));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	ut_assertok(spi_flash_erase_dm(dev, 0, 0x10000));
+	ut_assertok(dm_spi_get_mmap(dev, &map.base, &map.size, &map.offset));
+
+	/* Sandbox does not back the window with the flash, so fill it here */
+	win = map_sysmem(map.base, map.size);
+	saved = malloc(map.size);
+	ut_assertnonnull(saved);
+	memcpy(saved, win, map.size);
+	memset(win, 0xa5, map.size);
+
+	/* Reads inside the window come from it */
+	ut_assertok(spi_flash_read_mmap(dev, &map, 0x100, sizeof(buf), buf));
+	for (i = 0; i < sizeof(buf); i++)
+		ut_asserteq(0xa5, buf[i]);
+	ut_assertok(spi_flash_read_mmap(dev, &map, 0x2100 - sizeof(buf),
+					sizeof(buf), buf));
+	ut_asserteq(0xa5, buf[0]);
+
+	/* Reads before, after or across the end of the window use the flash */
+	ut_assertok(spi_flash_read_mmap(dev, &map, 0xf0, sizeof(buf), buf));
+	ut_asserteq(0xff, buf[0]);
+	ut_assertok(spi_flash_read_mmap(dev, &map, 0x2100, sizeof(buf), buf));
+	ut_asserteq(0xff, buf[0]);
+	ut_assertok(spi_flash_read_mmap(dev, &map, 0x2100 - 0x20, sizeof(buf),
+					buf));
+	ut_asserteq(0xff, buf[0]);
+
+	memcpy(win, saved, map.size);
+	free(saved);
+	unmap_sysmem(win);
+
+	/* Without a window everything uses the flash */
+	map.size = 0;
+	ut_assertok(spi_flash_read_mmap(dev, &map, 0x100, sizeof(buf), buf));
+	ut_asserteq(0xff, buf[0]);
+
+	/*
+	 * Since we are about to destroy all devices, we must tell sandbox
+	 * to forget the emulation device
+	 */
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_mmap, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Functional test that sandbox SPI flash works correctly */
 static int dm_test_spi_flash_func(struct unit_test_state *uts)
 {
@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for UBI devices and UBIFS
+ */
+
+#include <common.h>
+#include <command.h>
+#include <env.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <dm/test.h>
+#include <linux/mtd/mtd.h>
+#include <linux/sizes.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define UBI_TEST_PAGE_SIZE	512
+#define UBI_TEST_PEB_SIZE	SZ_16K
+#define UBI_TEST_PEB_COUNT	64
+#define UBI_TEST_VOL_SIZE	0x8000
+
+/* Size of the file in ubifs.img, which has a hole in its fifth block */
+#define UBIFS_TEST_FILE_SIZE	SZ_256K
+#define UBIFS_TEST_HOLE		(4 * SZ_4K)
+
+/* NAND-like flash in RAM which counts the reads of UBI headers */
+struct ubi_test_flash {
+	struct mtd_info mtd;
+	u8 *mem;
+	int reads;		/* all reads */
+	int ec_reads;		/* reads starting at an eraseblock */
+	int vid_reads;		/* reads starting at the VID header */
+};
+
+static struct ubi_test_flash *to_test_flash(struct mtd_info *mtd)
+{
+	return container_of(mtd, struct ubi_test_flash, mtd);
+}
+
+static int ubi_test_read(struct mtd_info *mtd, loff_t from, size_t len,
+			 size_t *retlen, u_char *buf)
+{
+	struct ubi_test_flash *flash = to_test_flash(mtd);
+	uint offset = from % UBI_TEST_PEB_SIZE;
+
+	flash->reads++;
+	if (!offset)
+		flash->ec_reads++;
+	else if (offset == UBI_TEST_PAGE_SIZE)
+		flash->vid_reads++;
+	memcpy(buf, flash->mem + from, len);
+	*retlen = len;
+
+	return 0;
+}
+
+static int ubi_test_write(struct mtd_info *mtd, loff_t to, size_t len,
+			  size_t *retlen, const u_char *buf)
+{
+	struct ubi_test_flash *flash = to_test_flash(mtd);
+	size_t i;
+
+	/* Programming can only clear bits */
+	for (i = 0; i < len; i++)
+		flash->mem[to + i] &= buf[i];
+	*retlen = len;
+
+	return 0;
+}
+
+static int ubi_test_erase(struct mtd_info *mtd, struct erase_info *instr)
+{
+	struct ubi_test_flash *flash = to_test_flash(mtd);
+
+	memset(flash->mem + instr->addr, 0xff, instr->len);
+	instr->state = MTD_ERASE_DONE;
+
+	return 0;
+}
+
+/* Register an erased flash called "ubitest" */
+static int ubi_test_flash_add(struct ubi_test_flash *flash)
+{
+	struct mtd_info *mtd = &flash->mtd;
+
+	memset(flash, '\0', sizeof(*flash));
+	mtd->name = "ubitest";
+	mtd->type = MTD_NANDFLASH;
+	mtd->flags = MTD_CAP_NANDFLASH;
+	mtd->size = UBI_TEST_PEB_COUNT * UBI_TEST_PEB_SIZE;
+	mtd->erasesize = UBI_TEST_PEB_SIZE;
+	mtd->writesize = UBI_TEST_PAGE_SIZE;
+	mtd->writebufsize = UBI_TEST_PAGE_SIZE;
+	mtd->_read = ubi_test_read;
+	mtd->_write = ubi_test_write;
+	mtd->_erase = ubi_test_erase;
+
+	flash->mem = malloc(mtd->size);
+	if (!flash->mem)
+		return -ENOMEM;
+	memset(flash->mem, 0xff, mtd->size);
+
+	return add_mtd_device(mtd);
+}
+
+static int ubi_test_flash_remove(struct ubi_test_flash *flash)
+{
+	int ret;
+
+	ret = del_mtd_device(&flash->mtd);
+	free(flash->mem);
+
+	return ret;
+}
+
+/*
+ * Attaching reads the EC and VID headers of each eraseblock with a single
+ * request, and volume data written before survives detaching
+ */
+static int dm_test_ubi_attach(struct unit_test_state *uts)
+{
+	struct ubi_test_flash flash;
+	u8 *src, *dst;
+	int i;
+
+	ut_assertok(ubi_test_flash_add(&flash));
+
+	/* An empty device is formatted on the first attach */
+	ut_assertok(run_command("ubi part ubitest", 0));
+	ut_assertok(run_command("ubi create test 8000", 0));
+	src = map_sysmem(0, UBI_TEST_VOL_SIZE);
+	for (i = 0; i < UBI_TEST_VOL_SIZE; i++)
+		src[i] = i * 7 + (i >> 8);
+	ut_assertok(run_command("ubi write 0 test 8000", 0));
+	ut_assertok(run_command("ubi detach", 0));
+
+	flash.ec_reads = 0;
+	flash.vid_reads = 0;
+	ut_assertok(run_command("ubi part ubitest", 0));
+	ut_asserteq(UBI_TEST_PEB_COUNT, flash.ec_reads);
+	ut_asserteq(0, flash.vid_reads);
+
+	dst = map_sysmem(0x10000, UBI_TEST_VOL_SIZE);
+	memset(dst, 0, UBI_TEST_VOL_SIZE);
+	ut_assertok(run_command("ubi read 10000 test 8000", 0));
+	ut_asserteq_mem(src, dst, UBI_TEST_VOL_SIZE);
+
+	ut_assertok(run_command("ubi detach", 0));
+	ut_assertok(ubi_test_flash_remove(&flash));
+
+	return 0;
+}
+DM_TEST(dm_test_ubi_attach, 0);
+
+/* Load the file in ubifs.img and check its contents */
+static int ubifs_test_load(struct unit_test_state *uts)
+{
+	u8 *buf;
+	int i;
+
+	buf = map_sysmem(0x100000, UBIFS_TEST_FILE_SIZE);
+	memset(buf, 0xff, UBIFS_TEST_FILE_SIZE);
+	ut_assertok(run_command("ubifsload 100000 data", 0));
+	ut_asserteq(UBIFS_TEST_FILE_SIZE, env_get_hex("filesize", 0));
+
+	for (i = 0; i < UBIFS_TEST_FILE_SIZE; i++) {
+		u8 expect = i * 7 + (i >> 8);
+
+		if (i >= UBIFS_TEST_HOLE && i < UBIFS_TEST_HOLE + SZ_4K)
+			expect = 0;
+		ut_asserteq(expect, buf[i]);
+	}
+
+	return 0;
+}
+
+/*
+ * Loading a zstd-compressed file reads runs of data nodes in bulk and fills
+ * holes with zeroes. The image is created by test_ut.py.
+ */
+static int dm_test_ubifs_load(struct unit_test_state *uts)
+{
+	struct ubi_test_flash flash;
+	char cmd[40];
+	void *img;
+	int size;
+
+	if (!IS_ENABLED(CONFIG_CMD_UBIFS) ||
+	    os_read_file("ubifs.img", &img, &size))
+		return -EAGAIN;
+
+	ut_assertok(ubi_test_flash_add(&flash));
+	ut_assertok(run_command("ubi part ubitest", 0));
+	ut_assertok(run_command("ubi create fs", 0));
+	memcpy(map_sysmem(0, size), img, size);
+	os_free(img);
+	snprintf(cmd, sizeof(cmd), "ubi write 0 fs %x", size);
+	ut_assertok(run_command(cmd, 0));
+
+	ut_assertok(run_command("ubifsmount ubi0:fs", 0));
+	flash.reads = 0;
+	ut_assertok(ubifs_test_load(uts));
+	/*
+	 * Reading the 63 data nodes one by one takes more reads than that,
+	 * before counting the index nodes
+	 */
+	ut_assert(flash.reads < UBIFS_TEST_FILE_SIZE / SZ_4K / 2);
+
+	/* The decompression context is set up again after unmounting */
+	ut_assertok(run_command("ubifsumount", 0));
+	ut_assertok(run_command("ubifsmount ubi0:fs", 0));
+	ut_assertok(ubifs_test_load(uts));
+
+	ut_assertok(run_command("ubi detach", 0));
+	ut_assertok(ubi_test_flash_remove(&flash));
+
+	return 0;
+}
+DM_TEST(dm_test_ubifs_load, 0);
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the log of environment copies in SPI flash
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <env.h>
+#include <env_internal.h>
+#include <malloc.h>
+#include <os.h>
+#include <spi_flash.h>
+#include <linux/sizes.h>
+#include <test/env.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+/* Two 64 KiB sectors, so that an erase of the area can be cut short */
+#define ENV_TEST_SLOTS		(SZ_128K / CONFIG_ENV_SIZE)
+#define ENV_TEST_FLASH_SIZE	SZ_2M
+
+/* Set up a copy of the environment holding just count=@count */
+static void env_test_sf_fill(env_t *env, int count)
+{
+	memset(env, '\0', sizeof(*env));
+	snprintf((char *)env->data, ENV_SIZE, "count=%d", count);
+	env->crc = crc32(0, env->data, ENV_SIZE);
+}
+
+/*
+ * Check that the newest intact copy is count=@count, as read from the flash
+ * and from a copy of the area in memory
+ */
+static int env_test_sf_check(struct unit_test_state *uts,
+			     struct spi_flash *flash, int count)
+{
+	char expect[20];
+	env_t *env;
+	void *log;
+
+	snprintf(expect, sizeof(expect), "count=%d", count);
+	env = malloc(sizeof(*env));
+	ut_assertnonnull(env);
+	ut_assertok(env_sf_log_load(flash, 0, ENV_TEST_SLOTS, env));
+	ut_asserteq(crc32(0, env->data, ENV_SIZE), env->crc);
+	ut_asserteq_str(expect, (char *)env->data);
+	free(env);
+
+	log = malloc(SZ_128K);
+	ut_assertnonnull(log);
+	ut_assertok(spi_flash_read(flash, 0, SZ_128K, log));
+	env = env_sf_log_find_mapped(log, ENV_TEST_SLOTS);
+	ut_asserteq(crc32(0, env->data, ENV_SIZE), env->crc);
+	ut_asserteq_str(expect, (char *)env->data);
+	free(log);
+
+	return 0;
+}
+
+/* Check whether a slot is still erased */
+static int env_test_sf_erased(struct spi_flash *flash, int slot)
+{
+	u8 buf[8];
+	int i;
+
+	if (spi_flash_read(flash, slot * CONFIG_ENV_SIZE, sizeof(buf), buf))
+		return -EIO;
+	for (i = 0; i < sizeof(buf); i++) {
+		if (buf[i] != 0xff)
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Save a copy holding count=@count */
+static int env_test_sf_save(struct spi_flash *flash, env_t *env, int count)
+{
+	env_test_sf_fill(env, count);
+
+	return env_sf_log_save(flash, 0, ENV_TEST_SLOTS, env);
+}
+
+/* Test saving and loading copies, including after a power loss */
+static int env_test_sf_log(struct unit_test_state *uts)
+{
+	u8 junk[4] = { 0 };
+	struct spi_flash *flash;
+	struct udevice *dev;
+	env_t *env;
+	void *buf;
+	int i;
+
+	buf = malloc(ENV_TEST_FLASH_SIZE);
+	ut_assertnonnull(buf);
+	memset(buf, 0xff, ENV_TEST_FLASH_SIZE);
+	ut_assertok(os_write_file("spi.bin", buf, ENV_TEST_FLASH_SIZE));
+	free(buf);
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	flash = dev_get_uclass_priv(dev);
+	env = malloc(sizeof(*env));
+	ut_assertnonnull(env);
+
+	/* Each copy goes in the next slot and the newest one is loaded */
+	for (i = 1; i <= ENV_TEST_SLOTS; i++) {
+		ut_assertok(env_test_sf_save(flash, env, i));
+		ut_assertok(env_test_sf_check(uts, flash, i));
+	}
+
+	/* Once full, the area is erased and starts again */
+	ut_assertok(env_test_sf_save(flash, env, 100));
+	ut_assertok(env_test_sf_check(uts, flash, 100));
+	ut_asserteq(1, env_test_sf_erased(flash, 1));
+	ut_asserteq(1, env_test_sf_erased(flash, ENV_TEST_SLOTS - 1));
+
+	/*
+	 * Fill the area and cut the next erase short after the first sector.
+	 * The newest copy is still last, and the next save erases the rest.
+	 */
+	for (i = 1; i < ENV_TEST_SLOTS; i++)
+		ut_assertok(env_test_sf_save(flash, env, 100 + i));
+	ut_assertok(spi_flash_erase(flash, 0, SZ_64K));
+	ut_assertok(env_test_sf_check(uts, flash, 100 + ENV_TEST_SLOTS - 1));
+	ut_assertok(env_test_sf_save(flash, env, 200));
+	ut_assertok(env_test_sf_check(uts, flash, 200));
+	ut_asserteq(1, env_test_sf_erased(flash, ENV_TEST_SLOTS - 1));
+
+	/* A torn copy falls back to the one before */
+	ut_assertok(env_test_sf_save(flash, env, 201));
+	ut_assertok(spi_flash_write(flash, CONFIG_ENV_SIZE + 100, sizeof(junk),
+				    junk));
+	ut_assertok(env_test_sf_check(uts, flash, 200));
+
+	/* A next slot which is not completely erased is not written */
+	ut_assertok(spi_flash_write(flash, 2 * CONFIG_ENV_SIZE + 100,
+				    sizeof(junk), junk));
+	ut_assertok(env_test_sf_save(flash, env, 300));
+	ut_assertok(env_test_sf_check(uts, flash, 300));
+	ut_asserteq(1, env_test_sf_erased(flash, 1));
+	ut_asserteq(1, env_test_sf_erased(flash, 2));
+
+	free(env);
+
+	return 0;
+}
+ENV_TEST(env_test_sf_log, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
+
+/* Check whether the newest stored copy holds the string @var */
+static bool env_test_sf_stored(struct spi_flash *flash, const char *var)
+{
+	bool found = false;
+	env_t *env;
+	char *p;
+
+	env = malloc(sizeof(*env));
+	if (!env || env_sf_log_load(flash, CONFIG_ENV_OFFSET,
+				    CONFIG_ENV_SPI_LOG_SIZE / CONFIG_ENV_SIZE,
+				    env))
+		goto out;
+	for (p = (char *)env->data; *p; p += strlen(p) + 1) {
+		if (!strcmp(p, var))
+			found = true;
+	}
+out:
+	free(env);
+
+	return found;
+}
+
+/* Test saving a single variable without touching the environment in use */
+static int env_test_sf_save_var(struct unit_test_state *uts)
+{
+	struct spi_flash *flash;
+	struct udevice *dev;
+	const char *session;
+	void *buf;
+
+	buf = malloc(ENV_TEST_FLASH_SIZE);
+	ut_assertnonnull(buf);
+	memset(buf, 0xff, ENV_TEST_FLASH_SIZE);
+	ut_assertok(os_write_file("spi.bin", buf, ENV_TEST_FLASH_SIZE));
+	free(buf);
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	flash = dev_get_uclass_priv(dev);
+	ut_assertok(env_select("SPIFlash"));
+
+	ut_assertok(env_set("test_stored", "old"));
+	ut_assertok(env_save());
+	ut_assertok(env_set("test_session", "1"));
+	session = env_get("test_session");
+
+	/* Only the one variable is changed in storage */
+	ut_assertok(env_save_var("test_saved", "new"));
+	ut_asserteq_str("new", env_get("test_saved"));
+	ut_assert(env_test_sf_stored(flash, "test_saved=new"));
+	ut_assert(env_test_sf_stored(flash, "test_stored=old"));
+	ut_assert(!env_test_sf_stored(flash, "test_session=1"));
+
+	/* The environment in use was not imported again */
+	ut_asserteq_ptr(session, env_get("test_session"));
+
+	ut_assertok(env_save_var("test_stored", NULL));
+	ut_assertnull(env_get("test_stored"));
+	ut_assert(!env_test_sf_stored(flash, "test_stored=old"));
+	ut_assert(env_test_sf_stored(flash, "test_saved=new"));
+
+	/* Nothing is saved over a bad copy, nor is the default env loaded */
+	ut_assertok(spi_flash_erase(flash, CONFIG_ENV_OFFSET,
+				    CONFIG_ENV_SPI_LOG_SIZE));
+	ut_asserteq(-ENOMSG, env_save_var("test_saved", "newer"));
+	ut_asserteq_str("new", env_get("test_saved"));
+	ut_asserteq_ptr(session, env_get("test_session"));
+	ut_asserteq(1, env_test_sf_erased(flash, CONFIG_ENV_OFFSET /
+					  CONFIG_ENV_SIZE));
+
+	ut_assertok(env_select("nowhere"));
+	env_set("test_saved", NULL);
+	env_set("test_session", NULL);
+
+	return 0;
+}
+ENV_TEST(env_test_sf_save_var, UT_TESTF_DM | UT_TESTF_SCAN_FDT);
@@ -64,7 +64,7 @@ static int test_multi_alloc(struct unit_test_state *uts, const phys_addr_t ram,
 	const phys_addr_t ram_end = ram + ram_size;
 	const phys_addr_t alloc_64k_end = alloc_64k_addr + 0x10000;
 
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 	phys_addr_t a, a2, b, b2, c, d;
 
@@ -231,7 +231,7 @@ static int test_bigblock(struct unit_test_state *uts, const phys_addr_t ram)
 	const phys_size_t big_block_size = 0x10000000;
 	const phys_addr_t ram_end = ram + ram_size;
 	const phys_addr_t alloc_64k_addr = ram + 0x10000000;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 	phys_addr_t a, b;
 
@@ -297,7 +297,7 @@ static int test_noreserved(struct unit_test_state *uts, const phys_addr_t ram,
 {
 	const phys_size_t ram_size = 0x20000000;
 	const phys_addr_t ram_end = ram + ram_size;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 	phys_addr_t a, b;
 	const phys_addr_t alloc_size_aligned = (alloc_size + align - 1) &
@@ -388,7 +388,7 @@ static int lib_test_lmb_at_0(struct unit_test_state *uts)
 {
 	const phys_addr_t ram = 0;
 	const phys_size_t ram_size = 0x20000000;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 	phys_addr_t a, b;
 
@@ -429,7 +429,7 @@ static int lib_test_lmb_overlapping_reserve(struct unit_test_state *uts)
 {
 	const phys_addr_t ram = 0x40000000;
 	const phys_size_t ram_size = 0x20000000;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 
 	lmb_init(&lmb);
@@ -474,7 +474,7 @@ static int test_alloc_addr(struct unit_test_state *uts, const phys_addr_t ram)
 	const phys_size_t alloc_addr_a = ram + 0x8000000;
 	const phys_size_t alloc_addr_b = ram + 0x8000000 * 2;
 	const phys_size_t alloc_addr_c = ram + 0x8000000 * 3;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 	phys_addr_t a, b, c, d, e;
 
@@ -593,6 +593,46 @@ static int lib_test_lmb_alloc_addr(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_alloc_addr, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Check reserving a region in place, as used for the ramdisk and FDT */
+static int lib_test_lmb_alloc_in_place(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x20000000;
+	const phys_addr_t rsv = ram + 0x1000000;
+	struct lmb lmb = {};
+	phys_addr_t a;
+
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, ram, ram_size));
+	ut_asserteq(0, lmb_reserve(&lmb, rsv, 0x100000));
+
+	/* unaligned, too high or outside memory */
+	ut_asserteq(0, lmb_alloc_in_place(&lmb, ram + 0x800, 0x1000, 0x1000,
+					  0));
+	ut_asserteq(0, lmb_alloc_in_place(&lmb, ram, 0x2000, 0x1000,
+					  ram + 0x1000));
+	ut_asserteq(0, lmb_alloc_in_place(&lmb, ram + ram_size, 0x1000,
+					  0x1000, 0));
+
+	/* inside or overlapping a reserved region */
+	ut_asserteq(0, lmb_alloc_in_place(&lmb, rsv + 0x1000, 0x1000, 0x1000,
+					  0));
+	ut_asserteq(0, lmb_alloc_in_place(&lmb, rsv - 0x1000, 0x2000, 0x1000,
+					  0));
+	ASSERT_LMB(&lmb, ram, ram_size, 1, rsv, 0x100000, 0, 0, 0, 0);
+
+	/* a suitable region is reserved where it is */
+	a = lmb_alloc_in_place(&lmb, ram, 0x2000, 0x1000, ram + 0x2000);
+	ut_asserteq(ram, a);
+	a = lmb_alloc_in_place(&lmb, rsv + 0x100000, 0x1000, 0x1000, 0);
+	ut_asserteq(rsv + 0x100000, a);
+	ASSERT_LMB(&lmb, ram, ram_size, 2, ram, 0x2000, rsv, 0x101000, 0, 0);
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_alloc_in_place, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Simulate 512 MiB RAM, reserve 3 blocks, check addresses in between */
 static int test_get_unreserved_size(struct unit_test_state *uts,
 				    const phys_addr_t ram)
@@ -602,7 +642,7 @@ static int test_get_unreserved_size(struct unit_test_state *uts,
 	const phys_size_t alloc_addr_a = ram + 0x8000000;
 	const phys_size_t alloc_addr_b = ram + 0x8000000 * 2;
 	const phys_size_t alloc_addr_c = ram + 0x8000000 * 3;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 	phys_size_t s;
 
@@ -678,7 +718,7 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 			+ 1) * CONFIG_LMB_MAX_REGIONS;
 	const phys_size_t blk_size = 0x10000;
 	phys_addr_t offset;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	int ret, i;
 
 	lmb_init(&lmb);
@@ -697,51 +737,57 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
-	/*  error for the (CONFIG_LMB_MAX_REGIONS + 1) memory regions */
-	offset = ram + 2 * (CONFIG_LMB_MAX_REGIONS + 1) * ram_size;
+	/*  the (CONFIG_LMB_MAX_REGIONS + 1) memory region needs more space */
+	offset = ram + 2 * CONFIG_LMB_MAX_REGIONS * ram_size;
 	ret = lmb_add(&lmb, offset, ram_size);
-	ut_asserteq(ret, -1);
+	ut_asserteq(ret, 0);
 
-	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
+	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS + 1);
+	ut_asserteq(lmb.memory.max, 2 * CONFIG_LMB_MAX_REGIONS);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
-	/*  reserve CONFIG_LMB_MAX_REGIONS regions */
-	for (i = 0; i < CONFIG_LMB_MAX_REGIONS; i++) {
+	/*  reserve CONFIG_LMB_MAX_REGIONS regions, leaving the first free */
+	for (i = 1; i <= CONFIG_LMB_MAX_REGIONS; i++) {
 		offset = ram + 2 * i * blk_size;
 		ret = lmb_reserve(&lmb, offset, blk_size);
 		ut_asserteq(ret, 0);
 	}
 
-	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
+	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS + 1);
 	ut_asserteq(lmb.reserved.cnt, CONFIG_LMB_MAX_REGIONS);
 
-	/*  error for the 9th reserved blocks */
-	offset = ram + 2 * (CONFIG_LMB_MAX_REGIONS + 1) * blk_size;
-	ret = lmb_reserve(&lmb, offset, blk_size);
-	ut_asserteq(ret, -1);
+	/*  the (CONFIG_LMB_MAX_REGIONS + 1) reserved block goes first */
+	ret = lmb_reserve(&lmb, ram, blk_size);
+	ut_asserteq(ret, 0);
 
-	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS);
-	ut_asserteq(lmb.reserved.cnt, CONFIG_LMB_MAX_REGIONS);
+	ut_asserteq(lmb.memory.cnt, CONFIG_LMB_MAX_REGIONS + 1);
+	ut_asserteq(lmb.reserved.cnt, CONFIG_LMB_MAX_REGIONS + 1);
 
 	/*  check each regions */
-	for (i = 0; i < CONFIG_LMB_MAX_REGIONS; i++)
+	for (i = 0; i <= CONFIG_LMB_MAX_REGIONS; i++)
 		ut_asserteq(lmb.memory.region[i].base, ram + 2 * i * ram_size);
 
-	for (i = 0; i < CONFIG_LMB_MAX_REGIONS; i++)
+	for (i = 0; i <= CONFIG_LMB_MAX_REGIONS; i++)
 		ut_asserteq(lmb.reserved.region[i].base, ram + 2 * i * blk_size);
 
+	/* allocation skips the reserved blocks */
+	ut_asserteq(ram + blk_size,
+		    lmb_alloc_base(&lmb, blk_size, blk_size, 2 * blk_size));
+
+	lmb_uninit(&lmb);
+
 	return 0;
 }
-#endif
 
 DM_TEST(lib_test_lmb_max_regions,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+#endif
 
 static int lib_test_lmb_flags(struct unit_test_state *uts)
 {
 	const phys_addr_t ram = 0x40000000;
 	const phys_size_t ram_size = 0x20000000;
-	struct lmb lmb;
+	struct lmb lmb = {};
 	long ret;
 
 	lmb_init(&lmb);
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test and benchmark for crc32
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define CRC32_POLY		0xedb88320
+#define CRC32_PERF_SIZE		SZ_1M
+
+/* Bit-at-a-time reference without table, inversion or other tricks */
+static uint32_t crc32_bitwise(uint32_t crc, const u8 *p, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? CRC32_POLY : 0);
+	}
+
+	return crc;
+}
+
+static int lib_crc32(struct unit_test_state *uts)
+{
+	const char check[] = "123456789";
+	u8 buf[128];
+	uint32_t crc;
+	int offs, len;
+
+	ut_asserteq(0xcbf43926, crc32(0, check, strlen(check)));
+	ut_asserteq(0x340bc6d9, crc32_no_comp(~0, check, strlen(check)));
+
+	/* All alignments and the head, body and tail paths of each */
+	lib_test_fill(buf, sizeof(buf));
+	for (offs = 0; offs < 8; offs++) {
+		for (len = 0; len <= sizeof(buf) - offs; len++) {
+			crc = crc32_bitwise(~0, buf + offs, len);
+			ut_asserteq(crc, crc32_no_comp(~0, buf + offs, len));
+			ut_asserteq(~crc, crc32(0, buf + offs, len));
+		}
+	}
+
+	/* Incremental calculation */
+	crc = crc32(0, buf, 37);
+	ut_asserteq(crc32(0, buf, sizeof(buf)),
+		    crc32(crc, buf + 37, sizeof(buf) - 37));
+
+	return 0;
+}
+LIB_TEST(lib_crc32, 0);
+
+/* One table lookup per byte, as crc32_no_comp() did before slicing-by-8 */
+static uint32_t crc32_bytewise(const uint32_t *table, uint32_t crc,
+			       const u8 *p, size_t len)
+{
+	while (len--)
+		crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+static void crc32_perf_show(const char *name, ulong us)
+{
+	printf("%-10s %6lu us %6lu MiB/s\n", name, us,
+	       us ? CRC32_PERF_SIZE / SZ_1M * 1000000 / us : 0);
+}
+
+/*
+ * Throughput on a 1 MiB buffer of the byte-wise table loop and of the path
+ * crc32_no_comp() is built with: ARMv8 CRC instructions, slicing-by-8 or the
+ * word-wise table loop
+ */
+static int lib_crc32_perf(struct unit_test_state *uts)
+{
+	uint32_t table[256];
+	uint32_t crc, ref;
+	const char *name;
+	ulong start;
+	int i, j;
+	u8 *buf;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (crc & 1 ? CRC32_POLY : 0);
+		table[i] = crc;
+	}
+
+	buf = malloc(CRC32_PERF_SIZE);
+	ut_assertnonnull(buf);
+	lib_test_fill(buf, CRC32_PERF_SIZE);
+
+	start = timer_get_us();
+	ref = crc32_bytewise(table, ~0, buf, CRC32_PERF_SIZE);
+	crc32_perf_show("bytewise", timer_get_us() - start);
+
+	if (IS_ENABLED(CONFIG_ARM64_CRC32))
+		name = "arm64";
+	else if (IS_ENABLED(CONFIG_CRC32_SLICE_BY_8) &&
+		 __BYTE_ORDER == __LITTLE_ENDIAN)
+		name = "slice-by-8";
+	else
+		name = "word";
+	start = timer_get_us();
+	crc = crc32_no_comp(~0, buf, CRC32_PERF_SIZE);
+	crc32_perf_show(name, timer_get_us() - start);
+	ut_asserteq(ref, crc);
+
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_crc32_perf, 0);
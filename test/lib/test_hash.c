@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test and benchmark for the hash algorithms
+ */
+
+#include <common.h>
+#include <hash.h>
+#include <malloc.h>
+#include <time.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+
+#define HASH_PERF_SIZE		SZ_1M
+#define HASH_TEST_BLOCKS	20
+
+/*
+ * Check the block function selected for this CPU against the generic one,
+ * for every count up to HASH_TEST_BLOCKS and from an unaligned buffer
+ */
+static int lib_hash_sha_process(struct unit_test_state *uts)
+{
+	u8 *buf;
+	int i;
+
+	buf = malloc(HASH_TEST_BLOCKS * SHA512_BLOCK_SIZE + 1);
+	ut_assertnonnull(buf);
+	lib_test_fill(buf, HASH_TEST_BLOCKS * SHA512_BLOCK_SIZE + 1);
+
+	for (i = 0; i <= HASH_TEST_BLOCKS; i++) {
+		if (IS_ENABLED(CONFIG_SHA256)) {
+			sha256_context ref, ctx;
+
+			sha256_starts(&ref);
+			sha256_starts(&ctx);
+			sha256_process_generic(&ref, buf + 1, i);
+			sha256_process(&ctx, buf + 1, i);
+			ut_asserteq_mem(ref.state, ctx.state, sizeof(ref.state));
+		}
+		if (IS_ENABLED(CONFIG_SHA512)) {
+			sha512_context ref, ctx;
+
+			sha512_starts(&ref);
+			sha512_starts(&ctx);
+			sha512_process_generic(&ref, buf + 1, i);
+			sha512_process(&ctx, buf + 1, i);
+			ut_asserteq_mem(ref.state, ctx.state, sizeof(ref.state));
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_hash_sha_process, 0);
+
+static void hash_perf_show(const char *name, ulong us)
+{
+	printf("%-10s %6lu us %6lu MiB/s\n", name, us,
+	       us ? HASH_PERF_SIZE / SZ_1M * 1000000 / us : 0);
+}
+
+/* Throughput of each hash algorithm on a 1 MiB buffer */
+static int lib_hash_perf(struct unit_test_state *uts)
+{
+	static const char *const names[] = {
+		"md5", "sha1", "sha256", "sha384", "sha512", "crc32",
+	};
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	ulong start;
+	u8 *buf;
+	int i;
+
+	buf = malloc(HASH_PERF_SIZE);
+	ut_assertnonnull(buf);
+	lib_test_fill(buf, HASH_PERF_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		if (hash_lookup_algo(names[i], &algo))
+			continue;
+		start = timer_get_us();
+		algo->hash_func_ws(buf, HASH_PERF_SIZE, output,
+				   algo->chunk_size);
+		hash_perf_show(algo->name, timer_get_us() - start);
+	}
+
+	/* The portable code, to compare with any accelerated version */
+	if (IS_ENABLED(CONFIG_SHA256)) {
+		sha256_context ctx;
+
+		sha256_starts(&ctx);
+		start = timer_get_us();
+		sha256_process_generic(&ctx, buf, HASH_PERF_SIZE / 64);
+		hash_perf_show("sha256-c", timer_get_us() - start);
+	}
+	if (IS_ENABLED(CONFIG_SHA512)) {
+		sha512_context ctx;
+
+		sha512_starts(&ctx);
+		start = timer_get_us();
+		sha512_process_generic(&ctx, buf,
+				       HASH_PERF_SIZE / SHA512_BLOCK_SIZE);
+		hash_perf_show("sha512-c", timer_get_us() - start);
+	}
+
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_hash_perf, 0);
@@ -0,0 +1,84 @@
+# SPDX-License-Identifier:      GPL-2.0+
+
+"""Test that UEFI variable changes are written before a reset
+
+While a UEFI image is running, changes of non-volatile variables are written
+to the variables file on the EFI system partition later. The selftests used
+here set a variable and then reset the system, directly or after
+ExitBootServices(). After restarting U-Boot the variable must be read back
+from the file.
+"""
+
+import os
+import shutil
+from subprocess import check_call
+import pytest
+
+VENDOR_GUID = '8b6c8ec1-9d12-4d2d-8c70-5e2af14d603b'
+
+@pytest.fixture(scope='function')
+def efi_var_file_data(u_boot_config):
+    """Set up an empty EFI system partition
+
+    Args:
+        u_boot_config -- U-boot configuration.
+
+    Return:
+        A path to disk image to be used for testing
+    """
+    mnt_point = u_boot_config.persistent_data_dir + '/test_efi_var_file'
+    image_path = u_boot_config.persistent_data_dir + '/efi_var_file.img'
+
+    shutil.rmtree(mnt_point, ignore_errors=True)
+    os.mkdir(mnt_point, mode = 0o755)
+    if os.path.exists(image_path):
+        os.remove(image_path)
+
+    check_call(f'virt-make-fs --partition=gpt --size=+1M --type=vfat {mnt_point} {image_path}',
+               shell=True)
+    check_call(f'sgdisk {image_path} -t 1:C12A7328-F81F-11D2-BA4B-00A0C93EC93B',
+               shell=True)
+
+    return image_path
+
+def run_selftest_and_check(u_boot_console, image_path, test, name):
+    """Run a selftest which resets and check the variable it set
+
+    Args:
+        u_boot_console -- U-Boot console
+        image_path -- Path to the disk image with the EFI system partition
+        test -- Name of the selftest
+        name -- Name of the variable set by the selftest
+    """
+    u_boot_console.restart_uboot()
+    u_boot_console.run_command(cmd = f'host bind 0 {image_path}')
+    u_boot_console.run_command(cmd = f'setenv efi_selftest {test}')
+    u_boot_console.run_command(cmd = 'bootefi selftest', wait_for_prompt=False)
+    if u_boot_console.p.expect(['resetting', 'U-Boot']) not in (0, 1):
+        raise Exception(f'Reset failed in \'{test}\' test')
+    u_boot_console.restart_uboot()
+
+    u_boot_console.run_command(cmd = f'host bind 0 {image_path}')
+    output = u_boot_console.run_command(cmd = f'printenv -e -guid {VENDOR_GUID} {name}')
+    assert '65 66 69 5f 73 74 00' in output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_bootefi_selftest')
+@pytest.mark.buildconfigspec('cmd_nvedit_efi')
+@pytest.mark.buildconfigspec('efi_variable_file_store')
+@pytest.mark.singlethread
+def test_efi_var_file_reset(u_boot_console, efi_var_file_data):
+    """Variable set by an image is written before ResetSystem()"""
+    run_selftest_and_check(u_boot_console, efi_var_file_data,
+                           'variables file reset', 'efi_st_var_reset')
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_bootefi_selftest')
+@pytest.mark.buildconfigspec('cmd_nvedit_efi')
+@pytest.mark.buildconfigspec('efi_variable_file_store')
+@pytest.mark.singlethread
+def test_efi_var_file_exit_boot_services(u_boot_console, efi_var_file_data):
+    """Variable set by an image is written at ExitBootServices()"""
+    run_selftest_and_check(u_boot_console, efi_var_file_data,
+                           'variables file exit boot services',
+                           'efi_st_var_ebs')
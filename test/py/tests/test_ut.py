@@ -282,6 +282,29 @@ label Fedora-Workstation-armhfp-31-1.9 (5.3.7-301.fc31.armv7hl)
         copy_prepared_image(cons, mmc_dev, fname)
 
 
+def setup_ubifs_image(cons):
+    """Create a UBIFS image for the UBIFS tests
+
+    The image fits the 16KB eraseblocks with 512-byte pages of the flash used
+    by dm_test_ubifs_load(). It holds a zstd-compressed 256KB file 'data'
+    whose fifth 4KB block is all zeroes, so that it is stored as a hole.
+
+    Args:
+        cons (ConsoleBase): Console to use
+    """
+    fname = os.path.join(cons.config.source_dir, 'ubifs.img')
+    mnt = os.path.join(cons.config.persistent_data_dir, 'ubifs')
+    mkdir_cond(mnt)
+
+    data = bytearray((i * 7 + (i >> 8)) & 0xff for i in range(256 * 1024))
+    data[4 * 4096:5 * 4096] = bytes(4096)
+    with open(os.path.join(mnt, 'data'), 'wb') as fd:
+        fd.write(data)
+
+    u_boot_utils.run_and_log(
+        cons, f'mkfs.ubifs -m 512 -e 15360 -c 60 -x zstd -r {mnt} -o {fname}')
+
+
 @pytest.mark.buildconfigspec('ut_dm')
 def test_ut_dm_init(u_boot_console):
     """Initialize data for ut dm tests."""
@@ -313,6 +336,9 @@ def test_ut_dm_init(u_boot_console):
     fs_helper.mk_fs(u_boot_console.config, 'fat32', 0x100000, '1MB',
                     use_src_dir=True)
 
+    if u_boot_console.config.buildconfig.get('config_cmd_ubifs', 'n') == 'y':
+        setup_ubifs_image(u_boot_console)
+
 @pytest.mark.buildconfigspec('cmd_bootflow')
 def test_ut_dm_init_bootstd(u_boot_console):
     """Initialise data for bootflow tests"""